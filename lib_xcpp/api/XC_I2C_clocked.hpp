@@ -0,0 +1,96 @@
+#ifndef _XC_I2C_CLOCKED_HPP_
+#define _XC_I2C_CLOCKED_HPP_
+
+//author: fabriceo
+//date:   october 2026
+//I2C master clocked by a clock block : scl and sda are 1 bit buffered ports in pull up mode (open drain),
+//4 slots per bit. each bit is (scl low, sda previous) (scl low, sda new) (scl high) (scl high).
+//a byte is queued in 2 segments : the first bit until its rising edge, then the 7 other bits and the
+//acknowledge clock until its rising edge. after each segment the thread waits scl high with peek, so
+//clock stretching by the slave is detected on the first bit and on the acknowledge, as in XC_I2Cmaster,
+//then the next segment starts on a new port time. stretching during bits 2 to 8 of a byte is NOT
+//detected : the queued slots continue and the bits are lost, such slaves need XC_I2Cmaster.
+//the divider gives scl low during at least the tLOW minimum of the speed mode (4.7us, 1.3us, 0.5us).
+//from the 100MHz reference clock, 1000kbit/s gives divide 13 and 961kbit/s on the bus, 400kbit/s gives
+//divide 33 and 379kbit/s. same write/read/writeReg API as XC_I2Cmaster, without client mode
+
+#include "XC_core.hpp"
+#include "XC_I2C_master.hpp"    //I2Cres_t
+
+//slots between the current port time and the start of a segment
+#ifndef XC_I2C_SLOTS_AHEAD
+#define XC_I2C_SLOTS_AHEAD 3
+#endif
+
+#if 0
+XCPort  scl(XS1_PORT_1H), sda(XS1_PORT_1I);
+XCClock cb(XC::CLKBLK_3);
+XCI2CClocked i2c(scl, sda, cb);
+void example() {
+    i2c.masterInit(1000);
+    unsigned val;
+    if (i2c.testDevice(0x18) == ACK) i2c.readReg(0x18, 0, val);
+}
+#endif
+
+class XCI2CClocked {
+public:
+    XCPort  &scl;
+    XCPort  &sda;
+    XCClock &clk;
+    unsigned stretched;     //segments where scl was still low after release (stretching or slow rise)
+    XCI2CClocked(XCPort &sc, XCPort &sd, XCClock &cb) :
+        scl(sc), sda(sd), clk(cb), stretched(0), kbits_per_second(0), divide(0), newDivide(0), busy(false) { }
+
+    //very first method to call : configure ports and clock block, then clear the bus with 9 clocks and a stop
+    void masterInit(unsigned kbitsps);
+    //recompute the divider from the new reference frequency, applied before the next transaction
+    void clockChanged() { if (kbits_per_second) newDivide = divideOf(kbits_per_second); }
+    static void clockChanged(void * i2c) { ((XCI2CClocked *)i2c)->clockChanged(); }
+    void stop();
+
+    void sendStopBit() { if (busy) stopBit(); }
+
+    I2Cres_t write( unsigned device,
+                    const unsigned n, const char buf[],
+                    unsigned &num_bytes_sent,
+                    bool send_stop_bit);
+
+    I2Cres_t read(  unsigned device,
+                    const unsigned m, char buf[],
+                    bool send_stop_bit);
+
+    I2Cres_t testDevice( unsigned device );
+
+    I2Cres_t writeReg( unsigned device, unsigned reg, unsigned val);
+
+    I2Cres_t readReg( unsigned device, unsigned reg, unsigned &val);
+
+    I2Cres_t writeRegs( unsigned device, unsigned reg, const unsigned n, const char buf[], unsigned &num_bytes_sent );
+
+    I2Cres_t readRegs( unsigned device, unsigned reg, const unsigned n, char buf[] );
+
+    I2Cres_t writeRegsTable( unsigned device, const char table[], bool multi = false);
+
+private:
+    XCSWLock lock;
+    unsigned kbits_per_second;
+    unsigned divide;            //clock block divider in use
+    volatile unsigned newDivide;
+    bool     busy;              //start bit sent, no stop bit yet
+    unsigned sclLevel;          //last slot queued on each port
+    unsigned sdaLevel;
+    unsigned divideOf(const unsigned kbitsps) const;
+    //new time base for both ports, few slots after the current port time
+    void align();
+    //wait the end of the queued slots, then scl high (stretching)
+    void release();
+    void startBit();
+    void stopBit();
+    //send 8 bits, return 0 for ACK
+    int  tx8(unsigned data);
+    //receive 8 bits and send ACK or NACK
+    unsigned rx8(const bool ack);
+};
+
+#endif //_XC_I2C_CLOCKED_HPP_
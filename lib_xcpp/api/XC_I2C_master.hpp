@@ -248,6 +248,11 @@ XCChanendPort& clientWaitAnswer() { return C.inPort(TO_I2C_CLIENT); }
 
 public:
 
+//recompute bit timings from the new reference frequency, after a PLL change (see XCGovernor)
+void clockChanged() {
+    if (kbits_per_second) compute_ticks(kbits_per_second); }
+static void clockChanged(void * i2c) { ((XC_I2Cmaster *)i2c)->clockChanged(); }
+
 void sendStopBit(void) {
     if (0==kbits_per_second) return ;
     if (bus_busy) stop_bit();     //verify scl being already low   
@@ -0,0 +1,163 @@
+#ifndef _XC_I2C_QUEUE_HPP_
+#define _XC_I2C_QUEUE_HPP_
+
+//author: fabriceo
+//date:   october 2026
+//asynchronous I2C transactions : tasks submit descriptors in a ring without waiting for the bus,
+//an engine (task or dedicated thread) executes them in order on a XC_I2Cmaster or XCI2CClocked.
+//completion is reported by callback (in the engine thread), semaphore give (scheduler wakeup)
+//and/or a result byte followed by an END token on a chanend. the ring has one producer thread and
+//one engine, without lock : all tasks submitting to a queue must belong to the same thread.
+//run() blocks on a semaphore when the ring is empty, so an idle engine costs nothing. submit gives it
+//only when the engine is parked there : while the engine is busy a submit takes no lock. when the
+//engine is in another thread, it sees a submit to an idle queue after at most XC_SCHEDULER_SYNC_POLL
+//ticks (see XC_sync.hpp), so this setting bounds the added latency of the first transaction.
+//descriptors belong to the caller and must stay valid until done is true
+
+#include "XC_core.hpp"
+#include "XC_sync.hpp"
+#include "XC_I2C_master.hpp"
+
+#if 0
+XC_I2Cmaster i2c(scl, sda);
+XCI2CQueue<> queue(i2c);
+static XCI2CTransaction volume;
+void ui(void *) {
+    volume.setWrite(0x18, 0x41, nullptr, 1).data[ 0 ] = 0x20;
+    volume.fn = onVolumeDone;
+    queue.submit(volume);                               //returns immediately
+}
+void engine(void *) { i2c.masterInit(400); queue.run(); }
+#endif
+
+typedef enum {
+    I2C_QUEUE_READ   = 1,       //read n bytes, after the register if any
+    I2C_QUEUE_NOSTOP = 2        //no stop bit at the end, next transaction starts with a repeated start
+} I2CqueueFlags_t;
+
+struct XCI2CTransaction {
+    unsigned char device;
+    unsigned char flags;
+    short    reg;               //register sent first, -1 for none. transactions with a register always end with a stop
+    unsigned n;
+    char *   buf;               //null uses data, up to 4 bytes
+    char     data[ 4 ];
+    XC::voidFuncVoid_t * fn;    //completion callbacks, null if unused
+    void *   arg;
+    XCSemaphore * sem;
+    unsigned chanend;           //destination chanend, 0 if unused
+    //written by the engine
+    volatile I2Cres_t result;
+    unsigned sent;
+    volatile bool done;
+    int      submitted;         //timer value at submit
+    XCI2CTransaction() : device(0), flags(0), reg(-1), n(0), buf(nullptr), fn(nullptr), arg(nullptr),
+        sem(nullptr), chanend(0), result(NACK), sent(0), done(true), submitted(0) { }
+    XCI2CTransaction& setWrite(unsigned d, int r, char * b, unsigned len, bool stop = true) {
+        if ((b == nullptr) && (len > sizeof(data))) __builtin_trap();
+        device = d; reg = r; buf = b; n = len; flags = stop ? 0 : I2C_QUEUE_NOSTOP; return *this; }
+    XCI2CTransaction& setRead(unsigned d, int r, char * b, unsigned len, bool stop = true) {
+        if ((b == nullptr) && (len > sizeof(data))) __builtin_trap();
+        device = d; reg = r; buf = b; n = len; flags = I2C_QUEUE_READ | (stop ? 0 : I2C_QUEUE_NOSTOP); return *this; }
+};
+
+template< typename I2C = XC_I2Cmaster, unsigned SIZE = 16 >
+class XCI2CQueue {
+    static_assert((SIZE & (SIZE - 1)) == 0, "SIZE must be a power of 2");
+    I2C & bus;
+    XCI2CTransaction * ring[ SIZE ];
+    volatile unsigned head;     //written by the producer only
+    volatile unsigned tail;     //written by the engine only
+    volatile bool stopping;
+    volatile bool parked;       //engine about to take pending, written by both sides
+    XCSemaphore pending;        //given by submit when the engine is parked and by stop, taken by run
+    XCChanend notify;
+public:
+    //statistics, in timer ticks
+    unsigned submitted, completed, rejected, nacks;
+    unsigned maxDepth;
+    unsigned latencyMin, latencyMax;    //submit to completion
+    unsigned long long latencyTotal;
+    unsigned busMax;                    //transaction duration on the bus
+
+    XCI2CQueue(I2C & i2c) : bus(i2c), head(0), tail(0), stopping(false), parked(false), pending(0) { clearStats(); }
+    void clearStats() {
+        submitted = completed = rejected = nacks = maxDepth = latencyMax = busMax = 0;
+        latencyMin = 0xFFFFFFFF; latencyTotal = 0; }
+    unsigned depth() const { return head - tail; }
+    unsigned latencyAverage() const { return completed ? latencyTotal / completed : 0; }
+
+    //queue a transaction, false if the ring is full
+    bool submit(XCI2CTransaction & t) {
+        const unsigned h = head;
+        if ((h - tail) >= SIZE) { rejected++; return false; }
+        t.done = false;
+        t.submitted = XC::getTime();
+        ring[ h & (SIZE - 1) ] = &t;
+        asm volatile("":::"memory");    //descriptor written before being published
+        head = h + 1;
+        submitted++;
+        const unsigned d = h + 1 - tail;
+        if (d > maxDepth) maxDepth = d;
+        asm volatile("":::"memory");    //head published before parked is read
+        if (parked) { parked = false; pending.give(); }
+        return true;
+    }
+
+    //execute the oldest transaction, false if the ring is empty
+    bool poll() {
+        const unsigned t = tail;
+        if (t == head) return false;
+        XCI2CTransaction & tr = *ring[ t & (SIZE - 1) ];
+        char * buf = tr.buf ? tr.buf : tr.data;
+        const bool stop = (tr.flags & I2C_QUEUE_NOSTOP) == 0;
+        const int start = XC::getTime();
+        I2Cres_t res;
+        unsigned sent = 0;
+        if (tr.flags & I2C_QUEUE_READ) {
+            if (tr.reg >= 0) res = bus.readRegs(tr.device, tr.reg, tr.n, buf);   //under the bus lock
+            else res = bus.read(tr.device, tr.n, buf, stop);
+            sent = (res == ACK) ? tr.n : 0;
+        } else {
+            if (tr.reg >= 0) res = bus.writeRegs(tr.device, tr.reg, tr.n, buf, sent);
+            else res = bus.write(tr.device, tr.n, buf, sent, stop);
+        }
+        const int end = XC::getTime();
+        const unsigned latency = end - tr.submitted;
+        if (latency > latencyMax) latencyMax = latency;
+        if (latency < latencyMin) latencyMin = latency;
+        latencyTotal += latency;
+        if ((unsigned)(end - start) > busMax) busMax = end - start;
+        if (res == NACK) nacks++;
+        completed++;
+        tr.result = res;
+        tr.sent = sent;
+        asm volatile("":::"memory");
+        tail = t + 1;
+        if (tr.fn) tr.fn(tr.arg);
+        if (tr.chanend) {
+            if (notify.addr == 0) notify.getResource();
+            notify.setDest(tr.chanend).outByte(res).outCT_END(); }
+        XCSemaphore * sem = tr.sem;
+        tr.done = true;     //last access, the caller may reuse the descriptor
+        if (sem) sem->give();
+        return true;
+    }
+
+    //engine loop, blocked while the ring is empty. returns after stop() once the ring is empty
+    void run() {
+        while (1) {
+            if (poll()) continue;
+            if (stopping) break;
+            parked = true;
+            asm volatile("":::"memory");    //parked published before head is read again
+            if ((tail != head) || stopping) { parked = false; continue; }
+            pending.take();         //a unit left when submit and the check above cross only costs one more loop
+            parked = false;
+        }
+    }
+    //the engine cannot be restarted after, a new queue is needed
+    void stop() { stopping = true; pending.give(); }
+};
+
+#endif //_XC_I2C_QUEUE_HPP_
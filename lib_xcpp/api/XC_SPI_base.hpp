@@ -2,6 +2,7 @@
 #define _XCSpi_BASE_HPP_
 
 #include "XC_core.hpp"
+#include "XC_scheduler.h"    //XCSchedulerYieldDelay in XCSpiLatchChain::run
 
 class XCSpi {
 //see https://en.wikipedia.org/wiki/Serial_Peripheral_Interface
@@ -55,17 +56,30 @@ public:
 };
 
 
+//shadow register of a latch, independent of the SPI bus, so that latches can be grouped in a chain
+class XCSpiLatchReg {
+protected:
+    unsigned reg;       //hold up to 32bits of informations to be latched
+    unsigned oldReg;    //previous value from last update
+    bool needUpdate_;
+public:
+    const unsigned bits;    //number of bits shifted for this latch
+    constexpr XCSpiLatchReg(unsigned n) : reg(0), oldReg(0), needUpdate_(true), bits(n) { }
+    bool needUpdate() const { return needUpdate_; }
+    bool changed() { return needUpdate_ || (needUpdate_ = (reg ^ oldReg)); }
+    //the register has been sent and latched
+    void updated() { needUpdate_ = false; oldReg = reg; }
+    unsigned value() const { return reg; }
+};
+
 //object class to structure access to latches and shift registers on the SPI bus.
 //rck is the port corresponding to the "latch" pin.
 //nbits is multiple of 8 and represents number of bits shiffted
 //type T gives the possibility to limit the value of bits according to an enum declaration
 template< XCSpi & SPI, XCPortBit &rck, unsigned nbits, typename T = unsigned >
-class XCSpiLatch {
-private:
-    unsigned reg;       //hold up to 32bits of informations to be latched
-    unsigned oldReg;    //previous value from last update
-    bool needUpdate_;
+class XCSpiLatch : public XCSpiLatchReg {
 public:
+    constexpr XCSpiLatch() : XCSpiLatchReg(nbits) { }
     //initialize the 32bits register with provided value and clear SPI_RCK line
     XCSpiLatch& init(unsigned val) { 
         reg = oldReg = val;
@@ -74,7 +88,6 @@ public:
         XC::delayTicks(SPI.period); 
         return *this; 
     }
-    bool needUpdate() { return needUpdate_; }
     XCSpiLatch& checkUpdate() { needUpdate_ = (reg ^ oldReg); return *this; }  
     //modify the 32bits register by setting some bits according to mask parameter
     XCSpiLatch&  set(unsigned val)      { reg = val; return *this; }
@@ -118,12 +131,65 @@ public:
         XC::delayTicks(SPI.period/2);
         rck.clr();                      //set SPI_RCKx to 0
         XC::delayTicks(SPI.period/2);
-        needUpdate_ = false; oldReg = reg;
+        updated();
         return *this;
     }
+    //same as update, only if the register changed since the last one
+    XCSpiLatch&  updateIfChanged() { if (changed()) update(); return *this; }
     operator unsigned () const { return get(); }
     XCSpiLatch& operator = (T rhs) { return set(rhs); }
 };
 
+//daisy chain of latches sharing the SPI bus and the rck pin. the registers are modified at any time by
+//the tasks of the thread owning the chain, then update() sends the whole chain in one frame, only if
+//at least one register changed, with a single rck pulse. the first latch added is the farthest from mosi.
+//up to 32 bits are packed in each SPI transfer
+template< XCSpi & SPI, XCPortBit &rck, unsigned maxLatches = 8 >
+class XCSpiLatchChain {
+    XCSpiLatchReg * latch[ maxLatches ];
+    unsigned count;
+public:
+    unsigned frames;    //frames sent
+    unsigned skipped;   //updates without change
+    XCSpiLatchChain() : count(0), frames(0), skipped(0) { }
+    XCSpiLatchChain& add(XCSpiLatchReg & l) {
+        if (count >= maxLatches) __builtin_trap();
+        latch[ count++ ] = &l;
+        return *this;
+    }
+    //clear rck, the first update will send the whole chain
+    XCSpiLatchChain& init() {
+        rck.clr();
+        XC::delayTicks(SPI.period);
+        frames = skipped = 0;
+        return *this;
+    }
+    //send the chain if any register changed, return true if a frame was sent
+    bool update(const bool force = false) {
+        bool dirty = force;
+        for (unsigned i = 0; i < count; i++) if (latch[ i ]->changed()) dirty = true;
+        if (dirty == false) { skipped++; return false; }
+        unsigned acc = 0, accBits = 0;
+        for (unsigned i = 0; i < count; i++) {
+            const unsigned n = latch[ i ]->bits;
+            const unsigned v = latch[ i ]->value();
+            if ((accBits + n) > 32) { SPI.transfer(acc, accBits); acc = accBits = 0; }
+            acc = (n >= 32) ? v : (acc << n) | (v & ((1UL << n) - 1));
+            accBits += n;
+        }
+        if (accBits) SPI.transfer(acc, accBits);
+        rck.set();                      //one latch pulse for the whole chain
+        XC::delayTicks(SPI.period/2);
+        rck.clr();
+        XC::delayTicks(SPI.period/2);
+        for (unsigned i = 0; i < count; i++) latch[ i ]->updated();
+        frames++;
+        return true;
+    }
+    //task body : one update per period, changes from other tasks during the period are merged in one frame
+    void run(const int period) {
+        while (1) { update(); XCSchedulerYieldDelay(period); }
+    }
+};
 
-#endif //_XCSpi_BASE_HPP_
\ No newline at end of file
+#endif //_XCSpi_BASE_HPP_
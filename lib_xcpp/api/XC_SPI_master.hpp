@@ -0,0 +1,158 @@
+#ifndef _XC_SPI_MASTER_HPP_
+#define _XC_SPI_MASTER_HPP_
+
+//author: fabriceo
+//date:   october 2026
+//SPI master clocked by a clock block : sclk, mosi and miso are 1 bit buffered ports with 32 bits transfer width.
+//the clock block runs at twice the bit rate, each bit uses 2 slots : sclk is output as a pattern (idle, active)
+//for cpha 0 or (active, idle) for cpha 1, mosi bits are doubled and miso is sampled in the second slot.
+//the 3 ports start on the same port time, then the thread only waits on in() between words.
+//from the 100MHz reference clock, divide 1 gives 25Mbit/s. the 4 modes are the same as XCSpi.
+//XCQSpiMaster uses the same clock block, sclk and chip select handling with a 4 bits data port
+
+#include "XC_core.hpp"
+
+#if 0
+XCPort  sclk(XS1_PORT_1A), mosi(XS1_PORT_1B), miso(XS1_PORT_1C);
+XCClock cb(XC::CLKBLK_1);
+XCSpiMaster spi(sclk, mosi, miso, cb);
+void example() {
+    spi.init(0, 1);                         //mode 0, 25Mbit/s
+    unsigned id = spi.transfer(0x9F00, 16);
+}
+XCPort  sio(XS1_PORT_4B);
+XCQSpiMaster qspi(sclk, sio, cb);
+static const XCQSpiMaster::command fastReadQuad = { 0xEB, 1, 3, 4, 6, 4, false };
+void exampleQuad(unsigned char * buf) {
+    qspi.setChipSelect(csPin);
+    qspi.init(0, 1);
+    qspi.read(fastReadQuad, 0x10000, buf, 4096);
+}
+#endif
+
+//clock block, sclk and chip select shared by the SPI and QSPI masters
+class XCSpiBus {
+public:
+    XCPort  &sclk;
+    XCClock &clk;
+    int      mode;      //cpol bit1, cpha bit0   00 01 10 11
+    int      divide;    //slot rate is source / (2 * divide), divide 0 is source
+    XCSpiBus(XCPort &sc, XCClock &cb, unsigned m, unsigned d) : sclk(sc), clk(cb), mode(m), divide(d), pattern(0), cs(nullptr) { }
+    //optional chip select, active low
+    void setChipSelect(XCPortBit & pin) { cs = &pin; pin.set(); }
+    void select()   { if (cs) cs->clr(); }
+    void deselect() { sclk.sync(); if (cs) cs->set(); }
+protected:
+    unsigned pattern;   //sclk slots, 2 per bit : (idle, active) for cpha 0 or (active, idle) for cpha 1
+    XCPortBit * cs;
+    //configure the clock block and sclk, before the data ports
+    void busInit(const bool xcore);
+    //start the clock block and drive sclk at its idle level, after the data ports
+    void busStart();
+    void busStop();
+    unsigned idle() const { return (mode & 2) ? 0xFFFFFFFF : 0; }
+    //port time of one idle slot queued on sclk : getts alone returns the time of the last output,
+    //which is in the past after the bus was idle for a while
+    unsigned portTime() { sclk.outPartialWord(idle(), 1); return sclk.getTriggerTime(); }
+};
+
+class XCSpiMaster : public XCSpiBus {
+public:
+    XCPort  &mosi;
+    XCPort  &miso;
+    //bit rate is source / (4 * divide)
+    XCSpiMaster(XCPort &sc, XCPort &mo, XCPort &mi, XCClock &cb, unsigned m = 0, unsigned d = 1) :
+        XCSpiBus(sc, cb, m, d), mosi(mo), miso(mi) { }
+    //configure clock block and ports, and drive sclk at its idle level.
+    //xcore true uses the core clock as source instead of the reference clock
+    void init(const bool xcore = false);
+    void init(unsigned m, unsigned d, const bool xcore = false) { mode = m; divide = d; init(xcore); }
+    //exchange up to 32 bits, msb first, same as XCSpi::transfer
+    unsigned transfer(unsigned val, const unsigned size);
+    //exchange n bytes, msb first, words streamed without gap. tx null sends 0xFF, rx null ignores received bytes.
+    //chip select is asserted during the block, and kept if release is false
+    void transferBlock(const unsigned char * tx, unsigned char * rx, const unsigned n, const bool release = true);
+    //stop the clock block and release the ports
+    void stop();
+    //16 bits to 32 slots with each bit doubled, and the 16 second slots of 32 slots
+    static unsigned slotsOf(const unsigned bits16);
+    static unsigned bitsOf(const unsigned slots);
+protected:
+    //align the 3 ports on a common port time, few slots ahead
+    void start();
+    //queue n <= 16 bits from val (lsb first) on sclk and mosi. only the last word of a transfer can be partial
+    void put(const unsigned val, const unsigned n);
+    //wait the 32 slots sampled for a word sent with put, return its n bits (lsb first)
+    unsigned get(const unsigned n);
+    //cpha 0 ends with sclk active, add one idle slot
+    void finish(const unsigned lastBit);
+};
+
+//consumer of the bytes received during one block of a stream, called by the engine before the next block
+typedef void XCSpiStreamRx_t(void * arg, const unsigned char * rx, const unsigned n);
+
+//double buffer between a producer thread and the thread running the SPI engine :
+//the producer fills one buffer while the other is clocked out, chip select is kept for the whole stream
+class XCSpiStream {
+    unsigned char * buf[ 2 ];
+    unsigned size;
+    volatile unsigned len[ 2 ];     //bytes posted in each buffer, 0 when free
+    unsigned produce, consume;      //buffer index used by each side
+    volatile bool ended;
+public:
+    XCSpiStream(unsigned char * a, unsigned char * b, const unsigned s) : size(s), produce(0), consume(0), ended(false) {
+        buf[ 0 ] = a; buf[ 1 ] = b; len[ 0 ] = len[ 1 ] = 0; }
+    unsigned capacity() const { return size; }
+    //producer : wait a free buffer and return it
+    unsigned char * acquire();
+    //producer : send the n bytes written in the buffer returned by acquire. 0 ends the stream
+    void post(const unsigned n);
+    //engine : clock out the buffers as they are posted, until the stream ends. received bytes are ignored,
+    //or stored in rx (capacity() bytes) and given to fn(arg, rx, n) after each block, rx being reused for the next one
+    void run(XCSpiMaster & spi, unsigned char * rx = nullptr, XCSpiStreamRx_t * fn = nullptr, void * arg = nullptr);
+};
+
+//quad SPI master : sio is a 4 bits buffered port (SIO0 on bit 0), 8 slots per 32 bits word, 2 slots per nibble.
+//each transaction has command, address, dummy and data phases, each phase on 1, 2 or 4 lanes.
+//single lane writes on SIO0 and reads on SIO1, as a standard SPI device. with ddr, address and data change
+//on both sclk edges (sclk toggles once per nibble). writes keep the exact number of clocks, reads restart
+//after the address on a free running sclk pattern, the extra clocks being ignored by the device.
+//an optional 4 bits loopback port, wired to sio, captures the data phase of writes for verification
+class XCQSpiMaster : public XCSpiBus {
+public:
+    XCPort  &sio;
+    //slot rate is source / (2 * divide), sdr quad gives 2 bits per slot
+    XCQSpiMaster(XCPort &sc, XCPort &io, XCClock &cb, unsigned m = 0, unsigned d = 1) :
+        XCSpiBus(sc, cb, m, d), sio(io), loop(nullptr) { }
+    struct command {
+        unsigned char code;         //command byte
+        unsigned char codeLanes;    //1, 2 or 4
+        unsigned char addrBytes;    //0 to 4
+        unsigned char addrLanes;
+        unsigned char dummy;        //sclk cycles between address and data
+        unsigned char dataLanes;
+        bool ddr;                   //address and data on both edges
+    };
+    void init(const bool xcore = false);
+    void init(unsigned m, unsigned d, const bool xcore = false) { mode = m; divide = d; init(xcore); }
+    void setLoopback(XCPort & p) { loop = &p; }
+    //command phases then n bytes read. chip select is handled automatically
+    void read(const command & c, const unsigned addr, unsigned char * rx, const unsigned n);
+    //command phases then n bytes written. echo receives the data phase captured on the loopback port
+    void write(const command & c, const unsigned addr, const unsigned char * tx, const unsigned n, unsigned char * echo = nullptr);
+    void stop();
+protected:
+    XCPort * loop;
+    unsigned acc, clkAcc, slots;    //words being built for sio and sclk
+    unsigned total;                 //slots queued since start
+    unsigned ddrCount;              //nibbles sent in ddr
+    unsigned last;                  //last nibble sent
+    unsigned t0;                    //port time of the first slot
+    void begin();
+    void flush();
+    void putNibble(const unsigned v, const bool ddr);
+    void putByte(const unsigned b, const unsigned lanes, const bool ddr);
+    void header(const command & c, const unsigned addr);
+};
+
+#endif //_XC_SPI_MASTER_HPP_
@@ -0,0 +1,56 @@
+#ifndef _XC_SPI_SLAVE_HPP_
+#define _XC_SPI_SLAVE_HPP_
+
+//author: fabriceo
+//date:   october 2026
+//SPI slave receiving from a host : a clock block is sourced by the external sclk pin and clocks mosi,
+//a 1 bit buffered port with 32 bits transfer width. the engine thread waits on a select between a full
+//mosi word and the chip select rising edge (port condition), and stores bytes in a ring buffer.
+//a consumer task or thread drains the ring in blocks. bytes received when the ring is full are counted
+//as dropped. miso is not driven, the host only writes. mosi is cleared before each chip select falling edge :
+//sclk must stay idle while cs is high (bus not shared with other devices)
+
+#include "XC_core.hpp"
+
+#if 0
+XCPort  sclk(XS1_PORT_1E), mosi(XS1_PORT_1F), cs(XS1_PORT_1G);
+XCClock cb(XC::CLKBLK_2);
+static XC_ALIGNED(4) unsigned char ring[ 4096 ];
+XCSpiSlave slave(sclk, mosi, cs, cb, ring, sizeof(ring));
+void engine(void *) { slave.init(0); slave.run(); }        //dedicated hardware thread
+void consumer(void *) { unsigned char block[ 256 ]; while (1) { slave.waitBlock(block, 256); /* ... */ } }
+#endif
+
+class XCSpiSlave {
+public:
+    XCPort  &sclk;
+    XCPort  &mosi;
+    XCPort  &cs;
+    XCClock &clk;
+    //ring must be word aligned (XC_ALIGNED(4)) and its size a power of 2 of at least 4 bytes, otherwise trap
+    XCSpiSlave(XCPort &sc, XCPort &mo, XCPort &c, XCClock &cb, unsigned char * ring, const unsigned size);
+    //configure the ports for the given mode (cpol bit1, cpha bit0)
+    void init(const unsigned mode = 0);
+    //engine loop, returns after stop() at the next chip select falling edge
+    void run();
+    void stop() { stopping = true; }
+    //consumer : bytes available in the ring
+    unsigned available() const { return head - tail; }
+    //consumer : copy up to max bytes, return the number copied
+    unsigned read(unsigned char * dst, const unsigned max);
+    //consumer : wait until n bytes are available (yielding to other tasks) and copy them
+    void waitBlock(unsigned char * dst, const unsigned n);
+    unsigned frames;            //chip select periods received
+    unsigned received;          //bytes stored
+    volatile unsigned dropped;  //bytes lost, ring full
+private:
+    unsigned char * ring;
+    unsigned mask;              //size - 1, size power of 2
+    volatile unsigned head;     //written by the engine only
+    volatile unsigned tail;     //written by the consumer only
+    volatile bool stopping;
+    void push(const unsigned word, const unsigned bytes);
+    void frame();
+};
+
+#endif //_XC_SPI_SLAVE_HPP_
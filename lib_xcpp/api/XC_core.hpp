@@ -14,10 +14,29 @@
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>     //for malloc
+#ifdef __cplusplus
+#include <new>          //for placement new
+#endif
 
 #ifdef __xcpp_conf_h_exists__
 #include "xcpp_conf.h"
 #endif
+#include "XC_stackpool.h"   //for XC::onejob stacks
+
+//reference clock used by the compile time conversions (XC::microsFixed...)
+#ifndef XC_REFERENCE_HZ
+#ifdef PLATFORM_REFERENCE_HZ
+#define XC_REFERENCE_HZ PLATFORM_REFERENCE_HZ
+#else
+#define XC_REFERENCE_HZ 100000000
+#endif
+#endif
+
+//set to 1 when the PLL is never changed : micros, millis and microsToTicks become inline compile time conversions
+//and setReferenceHz traps on any other frequency
+#ifndef XC_FIXED_REFERENCE_HZ
+#define XC_FIXED_REFERENCE_HZ 0
+#endif
 
 //various helpers macros
 
@@ -285,10 +304,8 @@ namespace XC {
   //imediately switch to next task in round robin list (if any) and return here only after a delay (in cpu ticks) with no jitter
   XC_UNUSED static void yieldDelaySync(int &localTime, unsigned delayticks) { 
 #ifdef XC_SCHEDULER_H
-    XCStaskPtr_t res;
     localTime = XCS_SET_TIME(delayticks);
-    do  res  = XCSchedulerYield();
-    while  ( ! XCS_END_TIME(localTime) );
+    XCSchedulerYieldUntil(localTime);
     return ;
 #endif
   };
@@ -553,22 +570,67 @@ namespace XC {
     //this will store the latest 64 bit time computed
     extern volatile LongLong_t getTime64Ticks;
     //returns a global timer value in 64 bits by extending internal gettime instruction
-    //needs to be called from any core at least every 10 seconds otherwise will loose 31bit overflow
-    //this needs to be called at least every 10 seconds otherwise will loose 31bit overflow
+    //needs to be called from any core at least every 20 seconds otherwise will loose 32bit overflow,
+    //unless startTime64Keeper() was called once
     //return 64 bits value representing more than 5000 years so will never rollout (always positive)
+    //safe from any core without lock : the snapshot is read and written with single LDD/STD instructions,
+    //so its two halves are always consistent, and the result is the exact extension of gettime as long as
+    //the snapshot is less than 2^31 ticks old. a core storing a slightly older snapshot after another one
+    //is then harmless, and results are monotonic across all threads
     inline long long getTime64() { asm volatile("### getTime64()");
-        
-        //load time in intermediate registers with 64bits LDD instruction
-        LongLong_t previous = { .ll = getTime64Ticks.ll };
+        LongLong_t previous;
+        asm volatile("ldd %0,%1,%2[0]":"=r"(previous.ulh.hi),"=r"(previous.ulh.lo):"r"(&getTime64Ticks):"memory");
         //maccu used as a single instruction to perform 64 bits addition of elapsed time
-        int elapsed = gettime() - previous.ulh.lo;
+        unsigned elapsed = gettime() - previous.ulh.lo;
         maccu(&previous.ull,elapsed,1);
-        //store 64bit result in a single STD instruction
-        getTime64Ticks.ll = previous.ull;
+        asm volatile("std %0,%1,%2[0]"::"r"(previous.ulh.hi),"r"(previous.ulh.lo),"r"(&getTime64Ticks):"memory");
         return previous.ll;
     }
 
 
+    //opt-in : start a dedicated hardware thread refreshing getTime64Ticks every 2^30 ticks,
+    //so getTime64, micros, millis and the timers based on them stay correct even if not called for minutes.
+    //the thread is paused on its own timer between refreshes (about 25 cycles every 10 seconds) and is never
+    //joined : one of the 8 threads of the tile and one timer are taken for the rest of the program, so a
+    //later par, XC::jobs or threadPool has one thread less (getst traps when none is left).
+    //the calling thread keeps its events and interrupts, so select, clre or the scheduler can be used freely.
+    //only one keeper per tile, next calls are ignored
+    void startTime64Keeper();
+    //same refresh done by a task of the cooperative scheduler of the calling thread, created by this call :
+    //no thread nor timer is taken, but a refresh is delayed as long as the other tasks do not yield
+    void startTime64KeeperTask();
+
+    //divide 64 bits ticks by RATIO known at compile time : a shift for a power of 2, otherwise
+    //two lmul with a constant factor, as the dynamic version. PREDIV keeps the factor within 32 bits
+    template<unsigned RATIO, unsigned PREDIV> inline long long ticksDivFixed(const long long ticks) {
+        static_assert(RATIO > 0, "invalid ratio");
+        static_assert(((RATIO & (RATIO - 1)) == 0) || (((1ULL << (32 + PREDIV)) / RATIO) < (1ULL << 32)), "PREDIV too large for this ratio");
+        if ((RATIO & (RATIO - 1)) == 0) return (unsigned long long)ticks >> __builtin_ctz(RATIO);
+        else {
+            //computed only here : for a power of 2 it may not fit in 32 bits, the static_assert allows it
+            const unsigned long long factor = (1ULL << (32 + PREDIV)) / RATIO;
+            LongLong_t local = { .ll = ticks };
+            local.ull >>= PREDIV;
+            XC_UNUSED unsigned temp;
+            asm("lmul %0,%1,%2,%3,%4,%5":"=r"(local.ulh.lo),"=r"(temp):"r"(local.ulh.lo),"r"((unsigned)factor),"r"(0),"r"(0));
+            asm("lmul %0,%1,%2,%3,%4,%5":"=r"(local.ulh.hi),"=r"(local.ulh.lo):"r"(local.ulh.hi),"r"((unsigned)factor),"r"(0),"r"(local.ulh.lo));
+            return local.ll; }
+    }
+
+    //compile time versions of micros and millis, for a PLL never changed. inlined, no global factor
+    template<unsigned HZ = XC_REFERENCE_HZ> inline long long microsFixed() {
+        static_assert((HZ % 1000000) == 0, "reference clock must be a multiple of 1MHz");
+        return ticksDivFixed<HZ / 1000000, 0>(getTime64()); }
+    template<unsigned HZ = XC_REFERENCE_HZ> inline long long millisFixed() {
+        static_assert((HZ % 1000) == 0, "reference clock must be a multiple of 1KHz");
+        return ticksDivFixed<HZ / 1000, 8>(getTime64()); }
+    //folded to a constant when us is constant
+    template<unsigned HZ = XC_REFERENCE_HZ> constexpr int microsToTicksFixed(const unsigned us) { return us * (HZ / 1000000); }
+
+#if XC_FIXED_REFERENCE_HZ
+    inline long long micros() { return microsFixed<>(); }
+    inline long long millis() { return millisFixed<>(); }
+#else
     //return the real time 64 bits timer value divided by a computed factor to represent microseconds.
     //return as "signed long long" is a choice in order to be abble to compare futur and actual easily
     //the number will never reach 63 bit as this would represent 2900 years of continuous execution
@@ -578,6 +640,7 @@ namespace XC {
     //return as "signed long long" is a choice in order to be abble to compare futur and actual easily
     //the number will never reach 63 bit as this would represent thousands of years of continuous execution
     long long millis();
+#endif
 
     //use the local thread timer to provide a blocking delay in microseconds. 
     //Maximum 10seconds
@@ -588,6 +651,7 @@ namespace XC {
     int delaySyncMicros(int &timeLast, unsigned delaymicros);
 
         //sets the number of ticks for 1 seconds. To be used after PLL changes to compte micros and millis factors
+    //a single thread may call it. micros and millis running on other threads meanwhile retry their computation
     void setReferenceHz(unsigned refhz);
 
     extern unsigned referenceHz;
@@ -1230,6 +1294,9 @@ public:
 
 class XCSWTimerMicros : public XCSWTimer<XC::micros> { };
 class XCSWTimerMillis : public XCSWTimer<XC::millis> { };
+//same with compile time conversions, when the PLL is never changed
+class XCSWTimerMicrosFixed : public XCSWTimer<XC::microsFixed<> > { };
+class XCSWTimerMillisFixed : public XCSWTimer<XC::millisFixed<> > { };
 
 /*
   when using "in" on a timer, the return value is exact same as gettime
@@ -1796,7 +1863,7 @@ typedef void voidFuncUnsigned_t(unsigned);
 
 //object used to decalre a job, as a task (function) with a stack size, e.g.
 //XC::onejob t1( task1, XC_NSTACKWORDS(task1), 1234 ); 
-//stack is allocated on heap by constructor, and freed by destructor when object comes out of scope
+//stack is taken from XCStackPool (or heap) by constructor, and given back by destructor when object comes out of scope
 #if 0
 void example() {
     XC::onejob t1( task1, XC_NSTACKWORDS(task1), 1234 ); 
@@ -1814,7 +1881,7 @@ struct onejob {
     unsigned stackBytes;    //number of bytes allocated
     void * stackPtr;        //point on allocated buffer
     void init() {
-        stackPtr = malloc(stackBytes);          //get a buffer in heap
+        stackPtr = XCStackPoolAlloc(&XCStackPool, stackBytes);  //get a block in the default pool, or in heap
         unsigned addr = (unsigned)stackPtr + stackBytes;  //point just after the given buffer
         pstack = (void*)( addr & ~7 );          //round down to ensure 8 bytes alligenment
     }
@@ -1822,7 +1889,7 @@ struct onejob {
         param(p),t(t_),stackBytes((size+1)*4) { init(); }
     onejob(XC::voidFuncUnsigned_t t_, unsigned size, unsigned p) :  onejob(t_,size,(void*)p) { }
     void start(unsigned sync) { XC::getCoreSyncStart(sync, (void *)t, pstack, param); }
-    void clear() { if (stackPtr) free(stackPtr); stackPtr = nullptr; }
+    void clear() { if (stackPtr) XCStackPoolFree(&XCStackPool, stackPtr); stackPtr = nullptr; }
     ~onejob() { clear(); }
 };
 
@@ -1902,6 +1969,406 @@ struct jobs {
     }
 };
 
+//return the .nstackwords of a function known at compile time, resolved at link time
+template<void (*F)(void *)> static inline unsigned nstackwordsOf() { 
+    unsigned n; asm("ldc %0, %c1.nstackwords":"=r"(n):"i"(F)); return n; }
+
+//job given to a worker of a threadPool. fn is cleared by the worker when taken
+struct threadSlot {
+    XC::voidFuncVoid_t * volatile fn;
+    void * volatile arg;
+};
+
+//worker loop of a threadPool : parked on a first ssync released by fork, execute the job found in its slot,
+//then a second ssync released by join, so join returns only once every job has returned
+static XC_NOINLINE void threadPoolWorker(void * p) {
+    threadSlot * slot = (threadSlot *)p;
+    while (1) {
+        XC::ssync();    //fork
+        XC::voidFuncVoid_t * fn = slot->fn;
+        void * arg = slot->arg;
+        slot->fn = nullptr;
+        if (fn) fn(arg);
+        XC::ssync();    //join
+    }
+}
+
+//persistent group of hardware threads, allocated once with their stacks, then reused by each fork/join
+//without getr, getst, init or malloc. all job functions share the STACKWORDS stack size of their worker :
+//nothing is checked when a job is given as a pointer, submit<fn>(i, arg) checks its .nstackwords (trap if above)
+#if 0
+void example() {
+    static XC::threadPool<3, 200> pool;
+    for (int frame = 0; ; frame++) {
+        pool.submit(0, dsp0, &buf0); pool.submit(1, dsp1, &buf1); pool.submit(2, dsp2, &buf2);
+        pool.fork();
+        /* dsp3 here */
+        pool.join();
+    }
+}
+#endif
+template<int N, int STACKWORDS = 256> class threadPool {
+static_assert((N >= 1) && (N <= 7),"invalid number of workers for XC::threadPool< >");
+    XC_ALIGNED(8) unsigned long long stacks[ N ][ (STACKWORDS+2)/2 ];
+    threadSlot slots[ N ];
+    unsigned synchronizer;
+public:
+    threadPool() : synchronizer(0) { for (int i = 0; i < N; i++) slots[ i ].fn = nullptr; }
+    //allocate the synchronizer and the N threads, done at first fork if not called before.
+    //the first msync only starts the threads : they run up to their fork ssync and are then parked
+    void start() {
+        if (synchronizer) return;
+        synchronizer = XC::getRessource(XC::TYPE_SYNC);
+        if (synchronizer == 0) __builtin_trap();
+        for (int i = 0; i < N; i++)
+            XC::getCoreSyncStart(synchronizer, (void *)&threadPoolWorker, &stacks[ i ][ (STACKWORDS+2)/2 - 1 ], &slots[ i ]);
+        XC::msync(synchronizer);
+    }
+    //give a job to worker i, executed at next fork. only while workers are parked (before fork or after join)
+    void submit(const unsigned i, XC::voidFuncVoid_t * fn, void * arg = nullptr) {
+        slots[ i ].arg = arg;
+        slots[ i ].fn  = fn; }
+    //same for a named function, its .nstackwords must fit in the worker stack
+    template<XC::voidFuncVoid_t * F> void submit(const unsigned i, void * arg = nullptr) {
+        if (nstackwordsOf<F>() > STACKWORDS) __builtin_trap();
+        submit(i, F, arg); }
+    //release the workers, once they are all parked
+    void fork() { start(); XC::msync(synchronizer); }
+    //wait until all workers have finished their job. they are then parked again
+    void join() { XC::msync(synchronizer); }
+    //terminate the parked workers, releasing their hardware threads and the synchronizer.
+    //only after join. a later fork starts them again
+    void stop() {
+        if (synchronizer == 0) return;
+        XC::mjoin(synchronizer);
+        XC::freerr(synchronizer);
+        synchronizer = 0; }
+    ~threadPool() { stop(); }
+};
+
+//split an index range in chunks of grain indexes, executed by the workers of a threadPool and by the caller.
+//CHUNK_STATIC gives chunk k to worker k modulo the number of workers, CHUNK_DYNAMIC gives the next free chunk
+//to the first worker available (a hardware lock is taken during the call)
+typedef enum { CHUNK_STATIC = 0, CHUNK_DYNAMIC = 1 } Chunking_t;
+
+#if 0
+void example() {
+    static XC::threadPool<7, 300> pool;
+    XC::parallelFor(pool, 0, 16, 2, [&](int from, int to) { for (int ch = from; ch < to; ch++) filter(ch); });
+    long long energy = XC::parallelReduce(pool, 0, 4096, 256, 0LL,
+        [&](int from, int to) { long long e = 0; for (int i = from; i < to; i++) e += (long long)x[i]*x[i]; return e; },
+        [](long long a, long long b) { return a + b; });
+}
+#endif
+
+//common part of the parallelFor and parallelReduce contexts
+struct parallelRange {
+    int begin, end, grain, workers;
+    Chunking_t mode;
+    unsigned lock;
+    volatile int next;
+};
+
+//argument given to each worker
+struct parallelArg { void * ctx; int id; };
+
+template<typename F> struct parallelForCtx : parallelRange {
+    F & fn;
+    parallelForCtx(F & f) : fn(f) { }
+    void chunk(int id, int from, int to) { fn(from, to); }
+};
+
+//each worker accumulates in its own entry. there is no data cache, so no false sharing to avoid
+template<typename T, typename F, typename C> struct parallelReduceCtx : parallelRange {
+    F & fn;
+    C & combine;
+    T partial[ 8 ];
+    parallelReduceCtx(F & f, C & c, T identity) : fn(f), combine(c) { for (int i = 0; i < 8; i++) partial[ i ] = identity; }
+    void chunk(int id, int from, int to) { partial[ id ] = combine(partial[ id ], fn(from, to)); }
+};
+
+//execute the chunks of worker id
+template<class CTX> static void parallelRun(CTX & c, const int id) {
+    if (c.mode == CHUNK_DYNAMIC) {
+        while (1) {
+            asm volatile("in %0,res[%0]"::"r"(c.lock):"memory");
+            int from = c.next;
+            c.next = from + c.grain;
+            asm volatile("out res[%0],%0"::"r"(c.lock):"memory");
+            if (from >= c.end) break;
+            int to = from + c.grain;
+            c.chunk(id, from, (to > c.end) ? c.end : to);
+        }
+    } else {
+        for (int from = c.begin + id * c.grain; from < c.end; from += c.workers * c.grain) {
+            int to = from + c.grain;
+            c.chunk(id, from, (to > c.end) ? c.end : to);
+        }
+    }
+}
+
+template<class CTX> static void parallelWorker(void * p) {
+    parallelArg * a = (parallelArg *)p;
+    parallelRun(*(CTX *)a->ctx, a->id);
+}
+
+//distribute the range on the W workers of the pool and on the caller (last worker)
+template<class CTX, int W, int S> static void parallelLaunch(threadPool<W,S> & pool, CTX & c) {
+    parallelArg args[ W ];
+    c.workers = W + 1;
+    if (c.grain <= 0) c.grain = 1;
+    c.lock = 0;
+    if (c.mode == CHUNK_DYNAMIC) {
+        c.lock = XC::getRessource(XC::TYPE_LOCK);
+        if (c.lock == 0) c.mode = CHUNK_STATIC;   //no more hardware lock available
+        c.next = c.begin; }
+    for (int i = 0; i < W; i++) { 
+        args[ i ].ctx = &c; args[ i ].id = i;
+        pool.submit(i, &parallelWorker<CTX>, &args[ i ]); }
+    pool.fork();
+    parallelRun(c, W);
+    pool.join();
+    if (c.lock) XC::freerr(c.lock);
+}
+
+//call fn(from, to) for each chunk of [begin, end[
+template<int W, int S, typename F> 
+void parallelFor(threadPool<W,S> & pool, int begin, int end, int grain, F fn, Chunking_t mode = CHUNK_STATIC) {
+    parallelForCtx<F> c(fn);
+    c.begin = begin; c.end = end; c.grain = grain; c.mode = mode;
+    parallelLaunch(pool, c);
+}
+
+//return combine() of all fn(from, to) results, starting from identity. 
+//partial results are combined in worker order, deterministic with CHUNK_STATIC chunking
+template<int W, int S, typename T, typename F, typename C> 
+T parallelReduce(threadPool<W,S> & pool, int begin, int end, int grain, T identity, F fn, C combine, Chunking_t mode = CHUNK_STATIC) {
+    parallelReduceCtx<T,F,C> c(fn, combine, identity);
+    c.begin = begin; c.end = end; c.grain = grain; c.mode = mode;
+    parallelLaunch(pool, c);
+    T result = identity;
+    for (int i = 0; i <= W; i++) result = combine(result, c.partial[ i ]);
+    return result;
+}
+
+//task stored in a work stealing deque
+struct stealTask { XC::voidFuncVoid_t * fn; void * arg; };
+
+//deque owned by one worker : the owner pushes and pops at bottom, other workers steal at top.
+//there is no compare and swap on xcore, so this uses the THE protocol of Cilk-5 : single word stores,
+//and a lock taken by thieves, and by the owner only when the deque is about to be empty
+template<int SIZE> struct stealDeque {
+static_assert((SIZE >= 2) && ((SIZE & (SIZE-1)) == 0),"SIZE must be a power of 2 for XC::stealDeque< >");
+    volatile int top;
+    volatile int bottom;
+    stealTask tasks[ SIZE ];
+    unsigned pushed;    //tasks pushed in this deque
+    unsigned done;      //tasks executed by the owner of this deque, including stolen ones
+    unsigned stolen;    //tasks stolen from siblings
+    unsigned busy;      //ticks spent executing tasks
+    void clear() { top = bottom = 0; pushed = done = stolen = busy = 0; }
+    //return false if the deque is full
+    bool push(const stealTask & t) {
+        int b = bottom;
+        if ((b - top) >= SIZE) return false;
+        pushed++;
+        tasks[ b & (SIZE-1) ] = t;
+        XC::barrier();
+        bottom = b + 1;
+        return true;
+    }
+    bool pop(stealTask & t, const unsigned lock) {
+        int b = bottom - 1;
+        bottom = b;
+        XC::barrier();
+        if (b < top) {
+            //a thief may be taking the last task, retry under lock
+            bottom = b + 1;
+            asm volatile("in %0,res[%0]"::"r"(lock):"memory");
+            b = bottom - 1;
+            bottom = b;
+            if (b < top) { 
+                bottom = b + 1; 
+                asm volatile("out res[%0],%0"::"r"(lock):"memory");
+                return false; }
+            asm volatile("out res[%0],%0"::"r"(lock):"memory");
+        }
+        t = tasks[ b & (SIZE-1) ];
+        return true;
+    }
+    bool steal(stealTask & t, const unsigned lock) {
+        bool res = false;
+        asm volatile("in %0,res[%0]"::"r"(lock):"memory");
+        int tp = top;
+        top = tp + 1;
+        XC::barrier();
+        if ((tp + 1) > bottom) top = tp;
+        else { t = tasks[ tp & (SIZE-1) ]; res = true; }
+        asm volatile("out res[%0],%0"::"r"(lock):"memory");
+        return res;
+    }
+};
+
+//work stealing runtime over a threadPool of N workers plus the calling thread.
+//tasks are pushed before run() or spawned by running tasks, each worker executes its own deque
+//and steals from its siblings when empty. run() returns when all tasks are executed
+#if 0
+void example() {
+    static XC::workStealing<7, 300, 64> ws;
+    for (int ch = 0; ch < 16; ch++) ws.push(ch % 8, processChannel, &channels[ ch ]);
+    ws.run();
+}
+#endif
+template<int N, int STACKWORDS = 256, int SIZE = 64> class workStealing {
+    threadPool<N, STACKWORDS> pool;
+    parallelArg args[ N ];
+    unsigned lock;
+    unsigned workerOf[ 8 ];     //worker index for each logical core, used by spawn
+    volatile unsigned stealing;
+    static void worker(void * p) { 
+        parallelArg * a = (parallelArg *)p; 
+        ((workStealing *)a->ctx)->loop(a->id); }
+    //true when every task pushed is executed. done is read before pushed, so that equal sums 
+    //guarantee no task was running (and able to spawn) when pushed counters were read
+    bool finished() {
+        unsigned done = 0, pushed = 0;
+        for (int i = 0; i <= N; i++) done += deques[ i ].done;
+        XC::barrier();
+        for (int i = 0; i <= N; i++) pushed += deques[ i ].pushed;
+        return done == pushed;
+    }
+    bool stealFrom(const int id, stealTask & t) {
+        for (int i = 1; i <= N; i++) {
+            int victim = id + i; if (victim > N) victim -= N + 1;
+            if ((deques[ victim ].bottom - deques[ victim ].top) > 0)
+                if (deques[ victim ].steal(t, lock)) { deques[ id ].stolen++; return true; }
+        }
+        return false;
+    }
+    void loop(const int id) {
+        workerOf[ XC::getid() ] = id;
+        stealDeque<SIZE> & dq = deques[ id ];
+        stealTask t;
+        while (1) {
+            if (dq.pop(t, lock) || (stealing && stealFrom(id, t))) {
+                int start = XC::getTime();
+                t.fn(t.arg);
+                dq.busy += XC::getTime() - start;
+                dq.done++;
+            } else if (finished()) break;
+        }
+    }
+public:
+    stealDeque<SIZE> deques[ N+1 ];
+    workStealing() : lock(0), stealing(1) { for (int i = 0; i <= N; i++) deques[ i ].clear(); }
+    //add a task in the deque of the given worker, before run(). executed immediately if the deque is full
+    void push(const unsigned id, XC::voidFuncVoid_t * fn, void * arg = nullptr) {
+        stealTask t = { fn, arg };
+        if (deques[ id ].push(t) == false) fn(arg); }
+    //add a task from a running task, in the deque of its worker
+    void spawn(XC::voidFuncVoid_t * fn, void * arg = nullptr) { push(workerOf[ XC::getid() ], fn, arg); }
+    //execute all tasks. steal = false keeps the initial distribution, for comparison
+    void run(const bool steal = true) {
+        if (lock == 0) lock = XC::getRessource(XC::TYPE_LOCK);
+        if (lock == 0) __builtin_trap();
+        stealing = steal;
+        for (int i = 0; i < N; i++) {
+            args[ i ].ctx = this; args[ i ].id = i;
+            pool.submit(i, &worker, &args[ i ]); }
+        pool.fork();
+        loop(N);
+        pool.join();
+    }
+    //sum of busy ticks of all workers, to compare with (N+1) x elapsed time
+    unsigned busy() const { unsigned b = 0; for (int i = 0; i <= N; i++) b += deques[ i ].busy; return b; }
+    //reset deques and counters, once run() has returned
+    void clear() { for (int i = 0; i <= N; i++) deques[ i ].clear(); }
+    //release the hardware threads of the pool and the lock, once run() has returned
+    void stop() {
+        pool.stop();
+        if (lock) XC::freerr(lock);
+        lock = 0; }
+    ~workStealing() { stop(); }
+};
+
+//default stack size in words of each XC_JOB. its frame (closure and stack) is a block of XCStackPool
+#ifndef XC_JOB_STACKWORDS
+#define XC_JOB_STACKWORDS (XC_STACKPOOL_WORDS - 16)
+#endif
+
+//return the .nstackwords of a named function of any type, resolved at link time.
+//not for lambdas or members : the symbol of their type is not usable in ldc
+template<typename T, T F> static inline unsigned nstackwordsOfFunction() {
+    unsigned n; asm("ldc %0, %c1.nstackwords":"=r"(n):"i"(F)); return n; }
+#define XC_NSTACKWORDS_OF(_f) XC::nstackwordsOfFunction<decltype(&_f), &_f>()
+
+//stack words used by jobEntry and the closure above the function called by XC_JOB_FUNC
+#ifndef XC_JOB_ENTRY_WORDS
+#define XC_JOB_ENTRY_WORDS 8
+#endif
+
+//entry point of a job thread : call the closure stored in the frame, then destroy it
+template<typename C> static void jobEntry(void * p) {
+    C * c = (C *)p;
+    (*c)();
+    c->~C();
+}
+
+//group of jobs launched on hardware threads with any callable and typed arguments, e.g.
+//XC::jobGroup g; XC_JOB(g, filter, &buf, 16); XC_JOB(g, obj->process, n); XC_JOB_LAMBDA(g, [&]{ x = y; });
+//g.join();   /* or at end of scope */
+//each spawn takes its own frame (closure and stack of W words), given back by join, so a call site can be used
+//in a loop or recursively. the frame is a block of XCStackPool when it fits in XC_STACKPOOL_WORDS and a block
+//is free : with the default W this leaves about 56 bytes for the closure. otherwise it silently comes from
+//malloc, which is always the case when XC_STACKPOOL_BLOCKS is 0.
+//only XC_JOB_FUNC checks the stack : the .nstackwords of its named function plus XC_JOB_ENTRY_WORDS must fit
+//in W (trap when launched). XC_JOB and XC_JOB_LAMBDA are not checked, their stack is sized with XC_JOB_STACK
+class jobGroup {
+    unsigned synchronizer;
+    unsigned started;
+    unsigned count;
+    void * frames[ 7 ];
+public:
+    jobGroup() : synchronizer(0), started(0), count(0) { }
+    //launch the callable on a new thread. words is the stack needed when known, 0 otherwise
+    template<int W = XC_JOB_STACKWORDS, typename C> jobGroup & spawn(C c, const unsigned words = 0) {
+        if ((count >= 7) || started) __builtin_trap();
+        if (words > W) __builtin_trap();    //increase stack with XC_JOB_STACK
+        if (synchronizer == 0) synchronizer = XC::getRessource(XC::TYPE_SYNC);
+        if (synchronizer == 0) __builtin_trap();
+        //closure at the bottom of the frame, stack above it
+        const unsigned closureBytes = (sizeof(C) + 7) & ~7;
+        const unsigned bytes = closureBytes + ((W+2)/2) * 8;
+        char * frame = (char *)XCStackPoolAlloc(&XCStackPool, bytes);
+        if (frame == nullptr) __builtin_trap();
+        frames[ count++ ] = frame;
+        C * closure = new (frame) C(c);
+        XC::getCoreSyncStart(synchronizer, (void *)&jobEntry<C>, frame + bytes - 8, closure);
+        return *this;
+    }
+    //start all jobs spawned, done by join if not called before
+    void start() { 
+        if (count && (started == 0)) { XC::msync(synchronizer); started = 1; } }
+    //wait the end of all jobs and release their frames
+    void join() {
+        start();
+        if (started) XC::mjoin(synchronizer);
+        for (unsigned i = 0; i < count; i++) XCStackPoolFree(&XCStackPool, frames[ i ]);
+        if (synchronizer) XC::freerr(synchronizer);
+        synchronizer = started = count = 0;
+    }
+    ~jobGroup() { join(); }
+};
+
+//launch a function or a member (through a pointer) with its arguments, captured by value. the call is direct
+#define XC_JOB(_g, _f, ...)             (_g).spawn([=]() mutable { _f(__VA_ARGS__); })
+//same for a named function only, with its stack checked against XC_JOB_STACKWORDS
+#define XC_JOB_FUNC(_g, _f, ...)        (_g).spawn([=]() mutable { _f(__VA_ARGS__); }, XC_NSTACKWORDS_OF(_f) + XC_JOB_ENTRY_WORDS)
+//same with a given stack size in words
+#define XC_JOB_STACK(_g, _w, _f, ...)   (_g).template spawn<_w>([=]() mutable { _f(__VA_ARGS__); })
+//launch a lambda or a callable object without parameter
+#define XC_JOB_LAMBDA(_g, ...)          (_g).spawn(__VA_ARGS__)
+
 //software version of the xcore crc32 instruction
 inline void crc32_(unsigned int & Crc, unsigned int Data, unsigned int poly) {
  for (unsigned i = 0; i < 32; i++) {
@@ -0,0 +1,139 @@
+#ifndef _XC_COROUTINE_HPP_
+#define _XC_COROUTINE_HPP_
+
+//author: fabriceo
+//date:   october 2026
+//stackless coroutines for small state machines (led, button, polling...) sharing one scheduler task.
+//each coroutine is an object deriving from XCCoroutine and implementing step() with the XC_CO_ macros below.
+//all coroutines of a runner are executed on the runner task stack, their state lives in the object itself.
+//as in protothreads, local variables are NOT preserved across an await : use class members.
+//the runner task sleeps when all coroutines wait for time or resources : it waits on all the resources
+//awaited with XCSchedulerYieldResources, plus its own timer set to the earliest deadline if any.
+//above XC_COROUTINE_WAIT_MAX distinct resources, they are polled at each scheduler pass.
+
+#include "XC_scheduler.h"
+#include <new>          //for placement new in XCCoroutineArena
+
+//maximum number of distinct resources awaited by the coroutines of a runner without polling
+#ifndef XC_COROUTINE_WAIT_MAX
+#define XC_COROUTINE_WAIT_MAX 8
+#endif
+
+#if 0
+class Blink : public XCCoroutine {
+    XCPort & led; unsigned i;
+public:
+    Blink(XCPort & p) : led(p) { }
+    bool step() {
+        XC_CO_BEGIN();
+        for (i = 0; i < 10; i++) {
+            led.outdXor(1);
+            XC_CO_AWAIT_DELAY(XC::getReferenceHz()/2);
+        }
+        XC_CO_END();
+    }
+};
+void example() {
+    static XCCoroutineRunner runner;
+    static Blink b(myLed);
+    runner.add(b);
+    runner.start();     //create the scheduler task executing all coroutines
+}
+#endif
+
+class XCCoroutineArenaBase;
+
+class XCCoroutine {
+public:
+    typedef enum { READY = 0, TIME, RESOURCE } Wait_t;
+    XCCoroutine * next;             //next coroutine in the runner list
+    XCCoroutineArenaBase * arena;   //arena where this object should be released when ended, if any
+    unsigned coLine;                //resume point, 0 at start
+    unsigned coWait;                //Wait_t : condition to meet before next step
+    int      coTime;                //deadline when waiting for TIME
+    unsigned coRes;                 //chanend, port or timer when waiting for RESOURCE
+
+    XCCoroutine() : next(nullptr), arena(nullptr), coLine(0), coWait(READY), coTime(0), coRes(0) { }
+    //execute until next await. return false when the coroutine is ended
+    virtual bool step() = 0;
+    //true if the awaited condition is met
+    bool ready() const {
+        switch (coWait) {
+        case TIME:      return XCS_END_TIME(coTime);
+        case RESOURCE:  return XCStestChan(coRes);
+        default:        return true; }
+    }
+};
+
+//macros to be used only inside step()
+#define XC_CO_BEGIN()           switch (coLine) { case 0:
+#define XC_CO_END()             } coLine = 0; return false
+//give back control to the runner, and resume here at next pass
+#define XC_CO_YIELD()           do { coWait = XCCoroutine::READY; coLine = __LINE__; return true; case __LINE__: ; } while (0)
+//resume when the global timer reach the given time
+#define XC_CO_AWAIT_UNTIL(_t)   do { coTime = (_t); coWait = XCCoroutine::TIME; coLine = __LINE__; return true; case __LINE__: ; } while (0)
+//resume after the given number of ticks
+#define XC_CO_AWAIT_DELAY(_d)   XC_CO_AWAIT_UNTIL( XCS_SET_TIME(_d) )
+//resume when a resource is ready to generate an event (data or token in chanend, timer or port condition met)
+#define XC_CO_AWAIT_RESOURCE(_r) do { coRes = (_r); coWait = XCCoroutine::RESOURCE; coLine = __LINE__; return true; case __LINE__: ; } while (0)
+//resume when data or token is present in the chanend
+#define XC_CO_AWAIT_CHANEND(_c) XC_CO_AWAIT_RESOURCE(_c)
+//resume when the port pins are equal (cond 0x11) or different (cond 0x19) to the value
+#define XC_CO_AWAIT_PORT(_p,_cond,_v) do { \
+        asm volatile("setc res[%0],%1 ; setd res[%0],%2"::"r"((unsigned)(_p)),"r"(_cond),"r"(_v)); \
+        XC_CO_AWAIT_RESOURCE(_p); } while (0)
+#define XC_CO_AWAIT_PORT_EQ(_p,_v)  XC_CO_AWAIT_PORT(_p,0x11,_v)
+#define XC_CO_AWAIT_PORT_NEQ(_p,_v) XC_CO_AWAIT_PORT(_p,0x19,_v)
+
+//fixed storage for coroutine objects created and ended dynamically
+class XCCoroutineArenaBase {
+public:
+    virtual void release(XCCoroutine * co) = 0;
+};
+
+template<class T, int N> class XCCoroutineArena : public XCCoroutineArenaBase {
+static_assert((N > 0) && (N <= 32),"invalid size for XCCoroutineArena< >");
+    alignas(T) char storage[ N ][ sizeof(T) ];
+    unsigned used;      //bit n set when storage[n] is allocated
+public:
+    XCCoroutineArena() : used(0) { }
+    //construct a new object in a free slot, or return nullptr if the arena is full
+    template<typename... Args> T * create(Args&&... args) {
+        for (int i = 0; i < N; i++) if ((used & (1 << i)) == 0) {
+            used |= 1 << i;
+            T * co = new (storage[ i ]) T(static_cast<Args&&>(args)...);
+            co->arena = this;
+            return co; }
+        return nullptr;
+    }
+    void release(XCCoroutine * co) {
+        unsigned i = ((char *)co - storage[ 0 ]) / sizeof(T);
+        static_cast<T *>(co)->~T();
+        used &= ~(1 << i);
+    }
+    unsigned count() const { return __builtin_popcount(used); }
+};
+
+//execute a list of coroutines within a single scheduler task
+class XCCoroutineRunner {
+public:
+    XCCoroutine * first;
+    unsigned resources[ XC_COROUTINE_WAIT_MAX + 1 ];    //distinct resources awaited during last pass, and the timer
+    unsigned count;         //number of resources collected by the last pass
+    unsigned timer;         //timer resource set to the earliest deadline when resources are awaited too, 0 until needed
+    XCCoroutineRunner() : first(nullptr), count(0), timer(0) { }
+    ~XCCoroutineRunner() { if (timer) asm volatile("freer res[%0]"::"r"(timer)); }
+    //add a coroutine at the begining of the list. can be called from a coroutine
+    void add(XCCoroutine & co) { co.coLine = 0; co.coWait = XCCoroutine::READY; co.next = first; first = &co; }
+    void add(XCCoroutine * co) { if (co) add(*co); }
+    //execute one pass over all coroutines ready to continue. return the earliest deadline in time,
+    //and in flags bit 0 if one coroutine was executed, bit 1 if one waits for a resource, bit 2 if one waits for time,
+    //bit 3 if more than XC_COROUTINE_WAIT_MAX distinct resources are awaited
+    int  pass(unsigned & flags);
+    //execute the coroutines until the list is empty, giving back control to the scheduler between passes
+    void run();
+    //create the scheduler task executing run(). all coroutine steps share this stack size (words)
+    XCStaskPtr_t start(const unsigned stackWords = 128, const unsigned priority = XCS_PRIORITY_NORMAL);
+};
+
+#endif //_XC_COROUTINE_HPP_
@@ -0,0 +1,68 @@
+#ifndef _XC_GOVERNOR_HPP_
+#define _XC_GOVERNOR_HPP_
+
+//author: fabriceo
+//date:   october 2026
+//frequency governor stepping the tile PLL between operating points according to the thread load.
+//the load of a thread is the share of time not spent idle in its cooperative scheduler (XCSchedulerIdleTicksOf).
+//the PLL is common to the tile, so the load used is the one of the busiest thread among those given to watch(),
+//by default the thread calling update(). a thread without scheduler is never idle : it should not be watched.
+//steps up as soon as the load exceeds the up threshold, to protect deadlines, and steps down
+//only after holdSamples consecutive samples below the down threshold (hysteresis).
+//after each transition referenceHz is updated (micros and millis stay continuous) and listeners
+//are called to recompute their tick values, like XC_I2Cmaster::clockChanged.
+//a transition blocks the calling thread during PLL::stabilize, about 15.6ms, without yielding :
+//update() should run in a thread whose other tasks can miss this time, not in a real time one
+
+#include "XC_scheduler.h"
+#include "XC_core.hpp"
+
+#if 0
+static const unsigned points[] = { pll200MHz, pll400MHz, pll600MHz };   //increasing frequencies
+static XCGovernor governor(points, 3);
+extern "C" void governorTask(unsigned p) {
+    governor.addListener(XC_I2Cmaster::clockChanged, &i2c);
+    while (1) { XCSchedulerYieldDelay(XC::getReferenceHz() / 10); governor.update(); }
+}
+#endif
+
+#ifndef XC_GOVERNOR_LISTENERS
+#define XC_GOVERNOR_LISTENERS 4
+#endif
+
+class XCGovernor {
+    const unsigned * points;    //PLL register values, by increasing frequency
+    unsigned count;
+    unsigned current;           //index of the active point
+    unsigned below;             //consecutive samples below the down threshold
+    unsigned cores;             //bit n set to watch the thread of logical core n, 0 for the calling thread
+    unsigned lastIdle[ 8 ], lastTime;
+    bool     windowStarted;     //lastIdle and lastTime are valid
+    XC::voidFuncVoid_t * listenerFn[ XC_GOVERNOR_LISTENERS ];
+    void * listenerArg[ XC_GOVERNOR_LISTENERS ];
+    unsigned listeners;
+    unsigned watched() const;
+    void startWindow();
+public:
+    unsigned upPercent;         //load above which the next point is selected
+    unsigned downPercent;       //load below which the previous point is selected after holdSamples
+    unsigned holdSamples;
+    unsigned transitions;
+    bool dryRun;                //decisions are recorded but the PLL is not written, for xsim tests
+    //starts on the highest point, assumed to be the one programmed at boot
+    XCGovernor(const unsigned * pll, const unsigned n, const unsigned up = 80, const unsigned down = 30, const unsigned hold = 4);
+    //select the threads whose load drives the decision, by logical core id mask (bit n for core n)
+    void watch(const unsigned coreMask) { cores = coreMask & 255; windowStarted = false; }
+    //called with the PLL changed, to recompute timings in ticks
+    void addListener(XC::voidFuncVoid_t * fn, void * arg = nullptr);
+    //control logic only : return the point to use for this load (0..100), updates the hysteresis state
+    unsigned step(const unsigned loadPercent);
+    //program the PLL with the given point, wait its stabilisation (15.6ms), update referenceHz and call listeners
+    void setPoint(const unsigned index);
+    //measure the load of the watched threads since last call, and apply the decision for the busiest.
+    //return its load
+    unsigned update();
+    unsigned point() const { return current; }
+};
+
+#endif //_XC_GOVERNOR_HPP_
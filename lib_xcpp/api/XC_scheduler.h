@@ -26,6 +26,39 @@
 #define XC_SCHEDULER_ROBIN_MODE 1
 #endif
 
+//number of priority levels per thread, each with its own round robin list (max 32).
+//the highest ready level is always selected. tasks are created with XCS_PRIORITY_NORMAL by default
+#ifndef XC_SCHEDULER_PRIORITIES
+#define XC_SCHEDULER_PRIORITIES 4
+#endif
+#define XCS_PRIORITY_LOW      0
+#define XCS_PRIORITY_NORMAL   1
+#define XCS_PRIORITY_HIGH     (XC_SCHEDULER_PRIORITIES-2)
+#define XCS_PRIORITY_CRITICAL (XC_SCHEDULER_PRIORITIES-1)
+
+//task stacks are painted at creation and a guard word is placed at their bottom.
+//when this flag is 1, the guard and the stack pointer of the task are checked at each yield,
+//and XCSchedulerStackOverflow() is called in case of corruption (default is a trap)
+#ifndef XC_SCHEDULER_STACK_CHECK
+#define XC_SCHEDULER_STACK_CHECK 1
+#endif
+#define XCS_STACK_GUARD 0xDEADBEEF
+#define XCS_STACK_PAINT 0x5AC35AC3
+
+//when set to 1, each task records its running time, number of yields and longest run between yields,
+//and each thread records an histogram of scheduling latency (from when a task is due until it runs)
+//in log2 bins of timer ticks. nothing is compiled when 0
+#ifndef XC_SCHEDULER_STATS
+#define XC_SCHEDULER_STATS 0
+#endif
+#define XCS_LATENCY_BINS 16
+
+//a thread with tasks blocked on a mutex, semaphore or event shared with other threads
+//checks its wake list at least with this period when all its tasks are blocked
+#ifndef XC_SCHEDULER_SYNC_POLL
+#define XC_SCHEDULER_SYNC_POLL 10000
+#endif
+
 #ifndef __ASSEMBLER__
 //provide the function adress into the given variable
 #define XCS_GET_FUNC_ADDRESS(_f,_n)     asm ("ldap r11," #_f " ; mov %0,r11" : "=r"(_n) :: "r11")
@@ -47,13 +80,58 @@ typedef struct XCStask_s {
 /* 4 */    struct XCStask_s* XCS_UNSAFE next;   //point on next task in queue
 /* 5 */    struct XCStask_s* XCS_UNSAFE prev;   //point on previous task in que
 /* 6 */    int timeAfter;          //contains a time after current time when the scheduler should come back
+/* 7 */    unsigned state;         //XCS_READY when in the round robin list, otherwise the reason for waiting
+/* 8 */    unsigned resource;      //chanend, port or timer when XCS_WAITING, event mask when XCS_BLOCKED
+/* 9 */    unsigned priority;      //priority level 0..XC_SCHEDULER_PRIORITIES-1, highest value runs first
+/* 10 */   unsigned stackTop;      //initial stack pointer, 0 for the main task which has no guard
+/* 11 */   unsigned core;          //logical core id of the thread running this task
+/* 12 */   struct XCStask_s* XCS_UNSAFE syncNext; //next task blocked on the same mutex, semaphore or event
+/* 13 */   const unsigned * XCS_UNSAFE resources; //resources awaited when XCS_WAITING, &resource for a single one
+/* 14 */   unsigned resourceCount; //number of entries in resources
+#if defined(XC_SCHEDULER_STATS) && (XC_SCHEDULER_STATS == 1)
+/* 15 */   int      readyTime;     //time when the task became due (end of sleep, event, or yield)
+/* 16 */   int      runStart;      //time when the task was resumed
+/* 17 */   unsigned runTicks;      //cumulated running time
+/* 18 */   unsigned yields;        //number of times the task yielded
+/* 19 */   unsigned longestRun;    //longest time between resume and yield
+#endif
 } XCStask_t;
 typedef XCStask_t * XCS_UNSAFE XCStaskPtr_t;
 
+//possible values for XCStask_t.state
+typedef enum { 
+    XCS_READY = 0,      //task is in the round robin list
+    XCS_SLEEPING,       //task is in the sleeping list, waiting for timeAfter
+    XCS_WAITING,        //task is in the waiting list, waiting for an event on one of its resources
+    XCS_BLOCKED,        //task is in the queue of a mutex, semaphore or event, and in the blocked list of its thread
+    XCS_ENDED,          //task function has returned, tcb about to be deallocated
+} XCStaskState_t;
+
+#if defined(XC_SCHEDULER_STATS) && (XC_SCHEDULER_STATS == 1)
+//copy of the counters of one task, as returned by XCSchedulerStatsSnapshot
+typedef struct XCStaskStats_s {
+    const char * XCS_UNSAFE name;
+    unsigned param;
+    unsigned priority;
+    unsigned state;
+    unsigned runTicks;
+    unsigned yields;
+    unsigned longestRun;
+} XCStaskStats_t;
+#endif
+
 typedef struct XCSthread_s {
 //dont change the structure order, some offset are used in assembly routines
 /* 0 */    XCStaskPtr_t current;  //point on the current task tcb (one which is running)
 /* 1 */    XCStaskPtr_t main;     //point on the main task tcb (the one which created the first second task)
+/* 2 */    XCStaskPtr_t sleep;    //point on the first sleeping task, list ordered by timeAfter
+/* 3 */    XCStaskPtr_t wait;     //point on the first task waiting for an event on a resource
+/* 4 */    unsigned idleTicks;    //cumulated time spent blocked while all tasks were sleeping or waiting
+/* 5 */    unsigned readyMask;    //bit n set when the round robin list of level n is not empty
+/* 6 */    XCStaskPtr_t wake;     //tasks released by another thread, to be inserted in ready lists (XCSsyncLock)
+/* 7 */    unsigned blocked;      //number of tasks of this thread blocked on a mutex, semaphore or event
+/* 8 */    XCStaskPtr_t blockedList; //tasks counted in blocked, linked with next and prev
+/* 9 */    XCStaskPtr_t ready[ XC_SCHEDULER_PRIORITIES ]; //next task to run in each level
 } XCSthread_t;
 
 //helper macros to automatically get the address of the task function AND its stack size.
@@ -68,6 +146,13 @@ typedef struct XCSthread_s {
 
 #define XCSchedulerCreateTask(_x) XCSchedulerCreateTaskParam(_x,0)
 
+//same as XCSchedulerCreateTaskParam with a priority level given as third parameter
+#define XCSchedulerCreateTaskPriority(_x,_y,_p) \
+        { const char name[] = #_x; \
+          unsigned addr;  XCS_GET_FUNC_ADDRESS(_x,addr); \
+          unsigned stack; XCS_GET_FUNC_NSTACKWORDS(_x,stack); \
+          XCSchedulerCreateTaskPriority_( addr, stack, (unsigned)&name, (_y), (_p) ); }
+
 #define XCSchedulerCreateTCBParam(_x,_y) \
         ({ const char name[] = #_x; \
           unsigned addr;  XCS_GET_FUNC_ADDRESS(_x,addr); \
@@ -77,6 +162,20 @@ typedef struct XCSthread_s {
 
 #define XCSchedulerCreateTCB(_x) XCSchedulerCreateTCBParam(_x,0)
 
+//object used as mutex, counting semaphore or event flags, shared by tasks of one or several threads.
+//all objects are protected by a single hardware lock per tile, as only 4 are available
+typedef struct XCSsync_s {
+    int count;              //semaphore count, 1 when a mutex is free, or event flags
+    XCStaskPtr_t owner;     //task holding the mutex
+    XCStaskPtr_t first;     //first task blocked, queue linked with syncNext
+    XCStaskPtr_t last;      //last task blocked
+} XCSsync_t;
+
+//wait modes for XCSchedulerEventWait
+#define XCS_EVENT_ANY   0   //wait for any bit of the mask
+#define XCS_EVENT_ALL   1   //wait for all bits of the mask
+#define XCS_EVENT_CLEAR 2   //clear the bits received before returning
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -84,12 +183,65 @@ extern "C" {
 //prototypes
 //add a task function in the list for the current thread, and allocate a stack
 XCStaskPtr_t XCSchedulerCreateTask_(const unsigned taskAddress, const unsigned stackSize, const unsigned name, const unsigned param);
+//same with a given priority level
+XCStaskPtr_t XCSchedulerCreateTaskPriority_(const unsigned taskAddress, const unsigned stackSize, const unsigned name, const unsigned param, const unsigned priority);
+//change the priority level of a task
+void XCSchedulerSetPriority(XCStaskPtr_t tcb, const unsigned priority);
 //switch to the next task into the list
 XCStaskPtr_t XCSchedulerYield();
-//switch to the next task into the list during max ticks 
+//remove the task from the list during max ticks, and switch to the next one
 XCStaskPtr_t XCSchedulerYieldDelay(const int max);
-//switch to the next task into the list while no data or token presence in a channel
+//remove the task from the list until the global timer reach the given time, and switch to the next one
+XCStaskPtr_t XCSchedulerYieldUntil(const int time);
+//return the time spent by the current thread blocked on its timer while all tasks were sleeping
+unsigned XCSchedulerIdleTicks();
+//same for the thread of the given logical core id, read from any thread
+unsigned XCSchedulerIdleTicksOf(const unsigned core);
+//remove the task from the list while no data or token presence in a channel, and switch to the next one
 XCStaskPtr_t XCSchedulerYieldChanend(unsigned ch);
+//remove the task from the list until the resource (chanend, port with condition, timer with condition)
+//is ready to generate an event, and switch to the next one. only one task may wait on a given resource :
+//its event vector designates the task, so a second waiter of the same thread traps
+XCStaskPtr_t XCSchedulerYieldResource(unsigned res);
+//same for a table of n resources, the task is resumed by the first one ready. the table must stay valid
+//until the task is resumed. a deadline is given with a timer resource set with condition after
+XCStaskPtr_t XCSchedulerYieldResources(const unsigned * XCS_UNSAFE res, const unsigned n);
+//return the maximum number of stack words used by the task since its creation (painted words overwritten)
+unsigned XCSchedulerStackPeak(XCStaskPtr_t tcb);
+//return 0 if the guard word of the task is intact and its stack pointer is above it
+unsigned XCSchedulerStackCheck(XCStaskPtr_t tcb);
+//called by the scheduler when the check fails on the task yielding. weak, can be redefined by the application
+void XCSchedulerStackOverflow(XCStaskPtr_t tcb);
+//initialize a semaphore with its count, or a mutex with 1 (free) or event flags with 0
+void XCSchedulerSyncInit(XCSsync_t * XCS_UNSAFE sync, const int count);
+//release the sync object, the hardware lock is given back with the last object. no task may be blocked on it
+void XCSchedulerSyncDeinit(XCSsync_t * XCS_UNSAFE sync);
+//take one unit of the semaphore, the task is blocked until available
+void XCSchedulerSemTake(XCSsync_t * XCS_UNSAFE sync);
+//take one unit if available, return 0 otherwise
+unsigned XCSchedulerSemTryTake(XCSsync_t * XCS_UNSAFE sync);
+//give one unit back, the first blocked task is released
+void XCSchedulerSemGive(XCSsync_t * XCS_UNSAFE sync);
+//lock the mutex, the task is blocked until the owner unlocks it
+void XCSchedulerMutexLock(XCSsync_t * XCS_UNSAFE sync);
+//unlock the mutex and give it to the first blocked task
+void XCSchedulerMutexUnlock(XCSsync_t * XCS_UNSAFE sync);
+//wait for event flags in the mask (mode XCS_EVENT_xxx), return the flags at wakeup
+unsigned XCSchedulerEventWait(XCSsync_t * XCS_UNSAFE sync, const unsigned mask, const unsigned mode);
+//set event flags and release the tasks waiting for them
+void XCSchedulerEventSet(XCSsync_t * XCS_UNSAFE sync, const unsigned mask);
+//clear event flags
+void XCSchedulerEventClear(XCSsync_t * XCS_UNSAFE sync, const unsigned mask);
+#if defined(XC_SCHEDULER_STATS) && (XC_SCHEDULER_STATS == 1)
+//copy the counters of the tasks of the current thread in the given table, return the number of tasks
+unsigned XCSchedulerStatsSnapshot(XCStaskStats_t * XCS_UNSAFE table, const unsigned max);
+//copy the latency histogram of the current thread. bin n counts latencies from 2^(n-1) to 2^n-1 ticks
+void XCSchedulerLatencyHistogram(unsigned * XCS_UNSAFE hist);
+//reset all counters of the current thread and of its tasks
+void XCSchedulerStatsReset();
+//print the snapshot and the histogram with debug_printf
+void XCSchedulerStatsPrint();
+#endif
 
 #ifdef __cplusplus
 }
@@ -163,8 +315,21 @@ XCStaskPtr_t XCSchedulerCreateTCB_(const unsigned taskAddress, const unsigned st
 	#define _name 3
 	#define _next 4
 	#define _prev 5
-  #define _timeAfter 6
-  #define _tcbsize 7
+	#define _timeAfter 6
+	#define _state 7
+	#define _resource 8
+	#define _priority 9
+	#define _stackTop 10
+	#define _core 11
+	#define _syncNext 12
+	#define _resources 13
+	#define _resourceCount 14
+	#define _tcbsize 15
+
+	//offset for type XCSthread_t
+	#define _current 0
+	#define _main 1
+	#define _threadsize (9 + XC_SCHEDULER_PRIORITIES)
 
 #endif //__ASSEMBLER__
 
@@ -0,0 +1,80 @@
+/**
+ * @file XC_stackpool.h
+ *
+ * @section License
+ * Copyright (C) 2026, fabriceo
+ * https://github.com/fabriceo
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ */
+
+#ifndef XC_STACKPOOL_H
+#define XC_STACKPOOL_H
+
+#ifdef __xcpp_conf_h_exists__
+#include "xcpp_conf.h"
+#endif
+
+//fixed size blocks used as task stacks by the scheduler and by XC::onejob, instead of malloc/free.
+//allocation and release are O(1) and protected by a hardware lock, as the pool is shared by the tile.
+//the lock is taken at the first allocation from the pool and kept as long as the pool is used.
+//a request bigger than a block, or when the pool is empty, falls back to malloc and is counted.
+//size of one block in words, must cover the biggest .nstackwords of the tasks + tcb (about 16 words)
+#ifndef XC_STACKPOOL_WORDS
+#define XC_STACKPOOL_WORDS 256
+#endif
+//number of blocks in the default pool XCStackPool. the default 0 links no buffer and always uses malloc,
+//an application opts in with -DXC_STACKPOOL_BLOCKS=n (n x XC_STACKPOOL_WORDS words of static memory)
+#ifndef XC_STACKPOOL_BLOCKS
+#define XC_STACKPOOL_BLOCKS 0
+#endif
+
+#ifdef __XC__
+#define XCSP_UNSAFE unsafe
+#else
+#define XCSP_UNSAFE
+#endif
+
+typedef struct XCStackPool_s {
+    void * XCSP_UNSAFE free;    //first free block, each free block contains the address of the next one
+    void * XCSP_UNSAFE base;    //first block of the pool
+    void * XCSP_UNSAFE end;     //just after the last block
+    unsigned blockBytes;        //size of one block, multiple of 8
+    unsigned lock;              //hardware lock resource, 0 until first allocation
+    unsigned used;              //number of blocks currently allocated
+    unsigned highWater;         //maximum value reached by used
+    unsigned fallbacks;         //number of allocations served by malloc
+} XCStackPool_t;
+
+//default pool, initialized at startup
+extern XCStackPool_t XCStackPool;
+
+//helper macro to declare a static buffer for a pool of _n blocks of _w words
+#define XC_STACKPOOL_BUFFER(_name,_w,_n) unsigned long long _name[ (((_w)+1)/2) * (_n) ]
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//prepare a pool with the given buffer (8 bytes alligned) of n blocks of given size in words
+void   XCStackPoolInit(XCStackPool_t * XCSP_UNSAFE pool, void * XCSP_UNSAFE buffer, const unsigned words, const unsigned n);
+//return a block of at least the given size in bytes, or a malloc buffer if not possible
+void * XCSP_UNSAFE XCStackPoolAlloc(XCStackPool_t * XCSP_UNSAFE pool, const unsigned bytes);
+//give back a block to its pool, or to the heap if it was obtained by malloc
+void   XCStackPoolFree(XCStackPool_t * XCSP_UNSAFE pool, void * XCSP_UNSAFE block);
+//return the maximum number of blocks used simultaneously since init
+unsigned XCStackPoolHighWater(XCStackPool_t * XCSP_UNSAFE pool);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //XC_STACKPOOL_H
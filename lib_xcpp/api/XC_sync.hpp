@@ -0,0 +1,68 @@
+#ifndef _XC_SYNC_HPP_
+#define _XC_SYNC_HPP_
+
+//author: fabriceo
+//date:   october 2026
+//mutex, semaphore and event flags for tasks of the cooperative scheduler.
+//a blocked task leaves the round robin list and costs nothing until released.
+//objects can be shared by tasks of several threads of the same tile, they are then
+//protected by a single hardware lock, taken with the first object and given back with the last one
+//(see XCSchedulerSyncInit in XC_scheduler.c).
+//a task blocked by another thread is not woken up by an event : its thread sees the give, unlock or set
+//at its next yield, or when blocked, after at most XC_SCHEDULER_SYNC_POLL ticks (100us by default).
+//without scheduler the caller polls the object with the same period
+
+#include "XC_scheduler.h"
+
+#if 0
+XCMutex m;
+XCSemaphore s(0);
+extern "C" void producer(int n) { while (1) { m.lock(); /* ... */ m.unlock(); s.give(); XCSchedulerYield(); } }
+extern "C" void consumer(int n) { while (1) { s.take(); /* ... */ } }
+#endif
+
+class XCMutex {
+    XCSsync_t sync;
+public:
+    XCMutex() { XCSchedulerSyncInit(&sync, 1); }
+    ~XCMutex() { XCSchedulerSyncDeinit(&sync); }
+    void lock()   { XCSchedulerMutexLock(&sync); }
+    void unlock() { XCSchedulerMutexUnlock(&sync); }
+    XCStaskPtr_t owner() const { return sync.owner; }
+};
+
+//lock the mutex for the duration of a scope
+class XCMutexGuard {
+    XCMutex & m;
+public:
+    XCMutexGuard(XCMutex & m_) : m(m_) { m.lock(); }
+    ~XCMutexGuard() { m.unlock(); }
+};
+
+class XCSemaphore {
+    XCSsync_t sync;
+public:
+    XCSemaphore(const int count = 0) { XCSchedulerSyncInit(&sync, count); }
+    ~XCSemaphore() { XCSchedulerSyncDeinit(&sync); }
+    void take()        { XCSchedulerSemTake(&sync); }
+    bool tryTake()     { return XCSchedulerSemTryTake(&sync); }
+    void give()        { XCSchedulerSemGive(&sync); }
+    int  count() const { return sync.count; }
+};
+
+class XCEventFlags {
+    XCSsync_t sync;
+public:
+    XCEventFlags() { XCSchedulerSyncInit(&sync, 0); }
+    ~XCEventFlags() { XCSchedulerSyncDeinit(&sync); }
+    //wait any bit of the mask, and clear the bits received
+    unsigned waitAny(const unsigned mask) { return XCSchedulerEventWait(&sync, mask, XCS_EVENT_ANY | XCS_EVENT_CLEAR); }
+    //wait all bits of the mask, and clear them
+    unsigned waitAll(const unsigned mask) { return XCSchedulerEventWait(&sync, mask, XCS_EVENT_ALL | XCS_EVENT_CLEAR); }
+    unsigned wait(const unsigned mask, const unsigned mode) { return XCSchedulerEventWait(&sync, mask, mode); }
+    void set(const unsigned mask)   { XCSchedulerEventSet(&sync, mask); }
+    void clear(const unsigned mask) { XCSchedulerEventClear(&sync, mask); }
+    unsigned flags() const { return sync.count; }
+};
+
+#endif //_XC_SYNC_HPP_
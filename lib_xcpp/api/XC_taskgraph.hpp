@@ -0,0 +1,88 @@
+#ifndef _XC_TASKGRAPH_HPP_
+#define _XC_TASKGRAPH_HPP_
+
+//author: fabriceo
+//date:   october 2026
+//static graph of up to 32 steps with dependencies, each step is launched as soon as its inputs are done,
+//either on the hardware threads of a threadPool or on cooperative tasks of the current thread.
+//the critical path (longest chain of step durations) is computed after each run
+
+#include "XC_scheduler.h"
+#include "XC_core.hpp"
+
+#if 0
+static XC::graphNode boot[] = {
+    /* 0 */ { "pll",       pllWrite,   nullptr, XC::deps() },
+    /* 1 */ { "stabilize", pllWait,    nullptr, XC::deps(0) },
+    /* 2 */ { "i2c",       i2cInit,    nullptr, XC::deps(1) },
+    /* 3 */ { "dsp",       dspInit,    nullptr, XC::deps() },
+    /* 4 */ { "codec",     codecInit,  nullptr, XC::deps(2) },
+    /* 5 */ { "i2s",       i2sStart,   nullptr, XC::deps(3,4) },
+};
+void example() {
+    static XC::threadPool<2, 300> pool;
+    XC::taskGraph graph(boot, 6);
+    graph.run(pool);            //or graph.runTasks(2, 300) with the cooperative scheduler
+    //graph.makespan(), graph.criticalPath()
+}
+#endif
+
+namespace XC {
+
+//bit mask of the indexes of the steps given as dependencies
+constexpr unsigned deps() { return 0; }
+template<typename... T> constexpr unsigned deps(unsigned first, T... rest) { return (1u << first) | deps(rest...); }
+
+struct graphNode {
+    const char * name;
+    XC::voidFuncVoid_t * fn;
+    void * arg;
+    unsigned deps;      //mask of the steps to be done before this one, all with a lower index
+    int start;          //time when the step started, relative to the start of the graph
+    int end;            //time when the step ended, relative to the start of the graph
+    int path;           //longest chain of durations ending with this step
+};
+
+class taskGraph {
+    graphNode * nodes;
+    unsigned count;
+    unsigned all;               //mask of all steps
+    volatile unsigned taken;    //steps started
+    volatile unsigned done;     //steps finished
+    unsigned lock;
+    int t0;
+    static void worker(void * p);
+    //take a step whose dependencies are done, or return -1
+    int pick();
+    void launch();
+    void finish();
+public:
+    //steps must be declared after their dependencies (trap otherwise), which also excludes cycles
+    taskGraph(graphNode * n, const unsigned c);
+    //execute the graph on the workers of the pool and on the calling thread
+    template<int W, int S> void run(threadPool<W,S> & pool) {
+        launch();
+        for (int i = 0; i < W; i++) pool.submit(i, &worker, this);
+        pool.fork();
+        loop();
+        pool.join();
+        finish();
+    }
+    //execute the graph on n cooperative tasks of the current thread (with stackWords each) and on the caller.
+    //steps may then use XCSchedulerYieldDelay or other yields to let other steps progress
+    void runTasks(const unsigned n, const unsigned stackWords = 256);
+    //execute steps until all are done, yielding when none is ready
+    void loop();
+    //time from the start of the graph to the end of the last step
+    int makespan() const;
+    //longest chain of step durations through dependencies, lower bound of makespan
+    int criticalPath() const;
+    //index of the last step of the critical path, follow with criticalPrevious
+    int criticalLast() const;
+    //dependency of the step on the critical path, or -1
+    int criticalPrevious(const int i) const;
+};
+
+};  //namespace XC
+
+#endif //_XC_TASKGRAPH_HPP_
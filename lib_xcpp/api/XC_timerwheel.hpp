@@ -0,0 +1,73 @@
+#ifndef _XC_TIMERWHEEL_HPP_
+#define _XC_TIMERWHEEL_HPP_
+
+//author: fabriceo
+//date:   october 2026
+//hierarchical timer wheel owning many software timers, driven by a single time check per tick.
+//3 levels of 256, 64 and 64 slots cover 2^20 ticks (17 minutes with 1ms tick), longer delays are re-cascaded.
+//insert and cancel are O(1), expiry is amortized O(1). a wheel belongs to one thread (no lock)
+
+#include "XC_scheduler.h"
+#include "XC_core.hpp"
+#include "XC_sync.hpp"
+
+#if 0
+static XCTimerWheel wheel;            //1ms tick by default
+static XCWheelTimer ledTimer, timeout;
+void blink(void * p) { led.outdXor(1); }
+void example() {
+    wheel.start(ledTimer, 500, blink, nullptr, true);  //every 500 ticks
+    wheel.start(timeout, 2000, onTimeout);
+    while (1) { wheel.poll(); /* other things */ }     //or wheel.run() as a scheduler task body
+}
+#endif
+
+//double linked list node, each slot of the wheel is a circular list with a sentinel node
+struct XCWheelNode {
+    XCWheelNode * next;
+    XCWheelNode * prev;
+};
+
+class XCWheelTimer : public XCWheelNode {
+public:
+    unsigned expires;           //tick when the timer fires
+    unsigned period;            //rearm period in ticks, 0 for one shot
+    XC::voidFuncVoid_t * fn;    //callback, executed in the thread running poll()
+    void * arg;
+    XCWheelTimer() : expires(0), period(0), fn(nullptr), arg(nullptr) { next = prev = nullptr; }
+    bool active() const { return next != nullptr; }
+};
+
+class XCTimerWheel {
+    static const unsigned BITS0 = 8, BITS1 = 6;
+    static const unsigned SIZE0 = 1 << BITS0, SIZE1 = 1 << BITS1;
+    XCWheelNode tv1[ SIZE0 ];
+    XCWheelNode tv2[ SIZE1 ];
+    XCWheelNode tv3[ SIZE1 ];
+    unsigned current;           //tick being processed
+    unsigned tickTicks;         //duration of one tick in timer ticks
+    int nextTime;               //timer value of the next tick
+    unsigned count;             //timers active
+    void insert(XCWheelTimer * t);
+    void unlink(XCWheelNode * n);
+    unsigned cascade(XCWheelNode * tv, const unsigned index);
+    unsigned tick();
+public:
+    //the tick duration is given in timer ticks, default 1ms
+    XCTimerWheel(const unsigned tickTicks = 0);
+    //start or restart a timer firing in the given number of ticks (min 1), periodic if requested
+    void start(XCWheelTimer & t, const unsigned ticks, XC::voidFuncVoid_t * fn, void * arg = nullptr, const bool periodic = false);
+    //stop a timer, O(1)
+    void cancel(XCWheelTimer & t);
+    //process all ticks elapsed since last call, return the number of callbacks executed
+    unsigned poll();
+    //scheduler task body : sleep until each tick, then poll. never returns
+    void run();
+    //current tick count
+    unsigned now() const { return current; }
+    unsigned active() const { return count; }
+    //helper callback giving the XCSemaphore passed as arg, to wake a cooperative task blocked on take()
+    static void giveSemaphore(void * s) { ((XCSemaphore *)s)->give(); }
+};
+
+#endif //_XC_TIMERWHEEL_HPP_
@@ -0,0 +1,257 @@
+#include <xs1.h>
+#include "XC_scheduler.h"
+#include "XC_I2C_clocked.hpp"
+
+//4 bits to 16 slots, each bit repeated 4 times. computed at first init
+static unsigned short i2cQuadTable[ 16 ];
+
+static void i2cTables() {
+    if (i2cQuadTable[ 15 ]) return;
+    for (unsigned n = 0; n < 16; n++) {
+        unsigned q = 0;
+        for (unsigned i = 0; i < 4; i++) if (n & (1 << i)) q |= 0xF << (4*i);
+        i2cQuadTable[ n ] = q; }
+}
+
+//byte lsb first to 32 slots
+static inline unsigned quadOf(const unsigned b) {
+    return i2cQuadTable[ b & 15 ] | (i2cQuadTable[ (b >> 4) & 15 ] << 16);
+}
+
+unsigned XCI2CClocked::divideOf(const unsigned kbitsps) const {
+    //slot rate is source / (2 * divide), 4 slots per bit, rounded to the next lower speed
+    const unsigned ref = XC::getReferenceHz();
+    const unsigned slots2 = 8000 * kbitsps;
+    unsigned d = (ref + slots2 - 1) / slots2;
+    //scl is low during 2 slots (4 x divide ticks) : at least the tLOW minimum of the speed mode,
+    //e.g. 400kbit/s gives divide 33 and 379kbit/s, as divide 32 gives tLOW 1.28us only
+    const unsigned tLowNs = (kbitsps <= 100) ? 4700 : (kbitsps <= 400) ? 1300 : 500;
+    const unsigned dLow = ((unsigned long long)tLowNs * ref + 3999999999ULL) / 4000000000ULL;
+    if (d < dLow) d = dLow;
+    return (d > 255) ? 255 : d;
+}
+
+void XCI2CClocked::align() {
+    //getts alone returns the time of the last output, which is in the past after an idle period
+    scl.outPartialWord(sclLevel, 1);
+    const unsigned t = (scl.getTriggerTime() + XC_I2C_SLOTS_AHEAD) & 0xFFFF;
+    scl.setTriggerTime(t);
+    sda.setTriggerTime(t);
+}
+
+void XCI2CClocked::release() {
+    scl.sync();
+    sda.sync();
+    if ((scl.peek() & 1) == 0) {
+        stretched++;
+        while ((scl.peek() & 1) == 0) XCSchedulerYield();  //returns immediately if no scheduler
+    }
+    sclLevel = 1;
+    align();
+}
+
+//after start bit, both sda and scl are low
+void XCI2CClocked::startBit() {
+    if (busy) {
+        //repeated start : sda released while scl is low, then scl high
+        scl.outPartialWord(0xC, 4);
+        sda.outPartialWord(sdaLevel | 0xE, 4);
+        release();
+    } else {
+        //new divider from clockChanged, bus is idle
+        if (newDivide != divide) {
+            divide = newDivide;
+            clk.stop(); clk.setDivide(divide); clk.start(); }
+        align();
+    }
+    //sda falls while scl is high, then scl falls
+    scl.outPartialWord(0x7, 4);
+    sda.outPartialWord(0x1, 4);
+    sclLevel = sdaLevel = 0;
+    busy = true;
+}
+
+//scl low, sda low, scl high, sda high, then bus free time before next start
+void XCI2CClocked::stopBit() {
+    scl.outPartialWord(0x3FFC, 14);
+    sda.outPartialWord(0x3FF0 | sdaLevel, 14);
+    scl.sync();
+    sda.sync();
+    sclLevel = sdaLevel = 1;
+    busy = false;
+}
+
+int XCI2CClocked::tx8(unsigned data) {
+    //data is transmitted MSB first
+    asm("bitrev %0,%0 ; byterev %0,%0":"=r"(data):"0"(data));
+    const unsigned q = quadOf(data);
+    //first bit until its rising edge
+    scl.outPartialWord(sclLevel | 0x8, 4);
+    sda.outPartialWord((sdaLevel * 3) | ((q & 3) << 2), 4);
+    release();
+    //second half of the first bit, 7 bits, then sda released for the acknowledge clock
+    scl.out(0x99999999);
+    sda.out((q >> 2) | 0xC0000000);
+    release();
+    sdaLevel = 1;
+    return sda.peek() & 1;
+}
+
+unsigned XCI2CClocked::rx8(const bool ack) {
+    scl.outPartialWord(sclLevel | 0x8, 4);
+    sda.outPartialWord((sdaLevel * 3) | 0xC, 4);
+    release();
+    //sda becomes an input for 32 slots, each bit sampled in its second high slot, scl low at the end
+    scl.out(0x19999999);
+    const unsigned s = sda.in();
+    unsigned data = 0;
+    for (unsigned i = 0; i < 8; i++) data = (data << 1) | ((s >> (4*i)) & 1);
+    sclLevel = 0;
+    align();
+    //ACK after every byte until the final byte then NACK
+    sdaLevel = ack ? 0 : 1;
+    scl.outPartialWord(0x6, 3);
+    sda.outPartialWord(sdaLevel ? 7 : 0, 3);
+    release();
+    return data;
+}
+
+void XCI2CClocked::masterInit(unsigned kbitsps) {
+    i2cTables();
+    divide = newDivide = divideOf(kbitsps);
+    clk.enable().setSourceClkRef().setDivide(divide);
+    scl.enable().setClock(clk).setBuffered().setTransferWidth(32).setPullUp();
+    sda.enable().setClock(clk).setBuffered().setTransferWidth(32).setPullUp();
+    clk.start();
+    sclLevel = sdaLevel = 1;
+    busy = false;
+    align();
+    //9 clocks with sda released, in case a slave was left in the middle of a byte, then a stop
+    scl.out(0xCCCCCCCC).outPartialWord(0xC, 4);
+    sda.out(0xFFFFFFFF).outPartialWord(0xF, 4);
+    stopBit();
+    kbits_per_second = kbitsps;
+    lock.release();     //in case it was locked
+}
+
+void XCI2CClocked::stop() {
+    kbits_per_second = 0;
+    clk.stop();
+    scl.free(); sda.free();
+    clk.disable();
+}
+
+I2Cres_t XCI2CClocked::write( unsigned device,
+                              const unsigned n, const char buf[],
+                              unsigned &num_bytes_sent,
+                              bool send_stop_bit )
+{
+    if (0==kbits_per_second) return NACK;
+    startBit();
+    int res = tx8((device << 1) | 0); //aka "write=0"
+    unsigned j = 0;
+    for (; j < n; j++) {
+        if (res != 0) break;
+        res = tx8(buf[j]);
+    }
+    if (send_stop_bit) stopBit();
+    num_bytes_sent = j;
+    return (res == 0) ? ACK : NACK;
+}
+
+I2Cres_t XCI2CClocked::read( unsigned device,
+                             const unsigned m, char buf[],
+                             bool send_stop_bit )
+{
+    if (0==kbits_per_second) return NACK;
+    startBit();
+    int res = tx8((device << 1) | 1);   //send address + read=1 flag
+    if (res == 0)
+        for (unsigned j = 0; j < m; j++) buf[j] = rx8(j != (m-1));
+    if (send_stop_bit) stopBit();
+    return (res == 0) ? ACK : NACK;
+}
+
+I2Cres_t XCI2CClocked::testDevice( unsigned device ) {
+    if (0==kbits_per_second) return NACK;
+    lock.acquire();
+    unsigned sent;
+    I2Cres_t res = write(device, 0, nullptr, sent, true);
+    lock.release();
+    return res;
+}
+
+I2Cres_t XCI2CClocked::writeReg( unsigned device, unsigned reg, unsigned val) {
+    if (0==kbits_per_second) return NACK;
+    lock.acquire();
+    char dummy[2] = { (char)reg, (char)val };
+    unsigned n;
+    I2Cres_t res = write(device,2,dummy,n,true);
+    lock.release();
+    return res;
+}
+
+I2Cres_t XCI2CClocked::readReg( unsigned device, unsigned reg, unsigned &val) {
+    if (0==kbits_per_second) return NACK;
+    lock.acquire();
+    char dummy[1] = { (char)reg };
+    unsigned n;
+    I2Cres_t res = write(device,1,dummy,n,false);
+    if (res == NACK) sendStopBit();
+    else {
+        res = read(device,1,dummy,true);
+        val = dummy[0];
+    }
+    lock.release();
+    return res;
+}
+
+I2Cres_t XCI2CClocked::writeRegs( unsigned device, unsigned reg, const unsigned n, const char buf[], unsigned &num_bytes_sent ) {
+    if (0==kbits_per_second) return NACK;
+    lock.acquire();
+    startBit();
+    int res = tx8((device << 1));
+    if (res == 0) res = tx8(reg);
+    unsigned j = 0;
+    for (; j < n; j++) {
+        if (res != 0) break;
+        res = tx8(buf[j]);
+    }
+    stopBit();
+    num_bytes_sent = j;
+    lock.release();
+    return (res == 0) ? ACK : NACK;
+}
+
+I2Cres_t XCI2CClocked::readRegs( unsigned device, unsigned reg, const unsigned n, char buf[] ) {
+    if (0==kbits_per_second) return NACK;
+    lock.acquire();
+    char dummy[1] = { (char)reg };
+    unsigned m;
+    I2Cres_t res = write(device,1,dummy,m,false);
+    if (res == NACK) sendStopBit();
+    else res = read(device,n,buf,true);
+    lock.release();
+    return res;
+}
+
+//same table format as XC_I2Cmaster::writeRegsTable : number of bytes, first register, values. ended with a 0
+I2Cres_t XCI2CClocked::writeRegsTable( unsigned device, const char table[], bool multi) {
+    const char *p = table;
+    I2Cres_t res = ACK;
+    while(*p) {
+        char tot   = *(p++);
+        char first = *(p++);
+        if (multi == false) {
+            for (unsigned i=0; i<tot; i++)
+                if ((res = writeReg( device, first+i,  p[i] )) == NACK) break;
+        } else {
+            unsigned n;
+            res = writeRegs(device, first, tot, p, n);
+            if (n != (unsigned)tot) res = NACK;
+        }
+        p += tot;
+        if (res==NACK) break;
+    } //while
+    return res;
+}
@@ -0,0 +1,319 @@
+#include <xs1.h>
+#include "XC_scheduler.h"
+#include "XC_SPI_master.hpp"
+
+//byte with each bit doubled, and the 4 odd bits of a byte. computed at first init
+static unsigned short spiDoubleTable[ 256 ];
+static unsigned char  spiOddTable[ 256 ];
+
+static void spiTables() {
+    if (spiDoubleTable[ 255 ]) return;
+    for (unsigned b = 0; b < 256; b++) {
+        unsigned d = 0, o = 0;
+        for (unsigned i = 0; i < 8; i++) if (b & (1 << i)) d |= 3 << (2*i);
+        for (unsigned i = 0; i < 4; i++) if (b & (2 << (2*i))) o |= 1 << i;
+        spiDoubleTable[ b ] = d;
+        spiOddTable[ b ] = o; }
+}
+
+unsigned XCSpiMaster::slotsOf(const unsigned x) {
+    return spiDoubleTable[ x & 255 ] | (spiDoubleTable[ (x >> 8) & 255 ] << 16);
+}
+
+unsigned XCSpiMaster::bitsOf(const unsigned s) {
+    return spiOddTable[ s & 255 ] | (spiOddTable[ (s >> 8) & 255 ] << 4)
+        | (spiOddTable[ (s >> 16) & 255 ] << 8) | (spiOddTable[ s >> 24 ] << 12);
+}
+
+void XCSpiBus::busInit(const bool xcore) {
+    const unsigned cpol = (mode >> 1) & 1, cpha = mode & 1;
+    //first slot of each bit is idle for cpha 0, active for cpha 1. slots are sent lsb first
+    pattern = (cpol ^ cpha) ? 0x55555555 : 0xAAAAAAAA;
+    clk.enable();
+    if (xcore) clk.setSourceClkXCore(); else clk.setSourceClkRef();
+    clk.setDivide(divide);
+    sclk.enable().setClock(clk).setBuffered().setTransferWidth(32);
+}
+
+void XCSpiBus::busStart() {
+    clk.start();
+    sclk.out(idle());
+    sclk.sync();
+}
+
+void XCSpiBus::busStop() {
+    clk.stop();
+    sclk.free();
+    clk.disable();
+}
+
+void XCSpiMaster::init(const bool xcore) {
+    spiTables();
+    busInit(xcore);
+    mosi.enable().setClock(clk).setBuffered().setTransferWidth(32);
+    miso.enable().setClock(clk).setBuffered().setTransferWidth(32);
+    busStart();
+    mosi.out(0);
+}
+
+void XCSpiMaster::stop() {
+    mosi.free(); miso.free();
+    busStop();
+}
+
+void XCSpiMaster::start() {
+    miso.clrBuffer();
+    //port time is 16 bits, 16 slots leave enough time to configure the 3 ports
+    unsigned t = (portTime() + 16) & 0xFFFF;
+    sclk.setTriggerTime(t);
+    mosi.setTriggerTime(t);
+    miso.setTriggerTime(t);
+}
+
+void XCSpiMaster::put(const unsigned val, const unsigned n) {
+    if (n == 16) {
+        sclk.out(pattern);
+        mosi.out(slotsOf(val));
+    } else {
+        sclk.outPartialWord(pattern, 2*n);
+        mosi.outPartialWord(slotsOf(val), 2*n); }
+}
+
+unsigned XCSpiMaster::get(const unsigned n) {
+    //the port samples continuously, slots after a partial word are ignored
+    unsigned res = bitsOf(miso.in());
+    return (n == 16) ? res : res & ((1 << n) - 1);
+}
+
+void XCSpiMaster::finish(const unsigned lastBit) {
+    if ((mode & 1) == 0) {
+        sclk.outPartialWord(pattern, 1);        //first slot is the idle level
+        mosi.outPartialWord(lastBit, 1); }
+}
+
+unsigned XCSpiMaster::transfer(unsigned val, const unsigned size) {
+    if ((size == 0) || (size > 32)) return 0;
+    val <<= (32-size);  //MSB first
+    asm("bitrev %0,%1":"=r"(val):"r"(val));
+    const unsigned n0 = (size > 16) ? 16 : size;
+    const unsigned n1 = size - n0;
+    start();
+    put(val, n0);
+    if (n1) put(val >> 16, n1);
+    finish((val >> (size - 1)) & 1);
+    unsigned res = get(n0);
+    if (n1) res |= get(n1) << 16;
+    //back to msb first
+    asm("bitrev %0,%1":"=r"(res):"r"(res));
+    return res >> (32-size);
+}
+
+//word i of a block : 2 bytes, first byte msb first, returned lsb first. the last word of an odd block has 8 bits
+static inline unsigned spiWord(const unsigned char * tx, const unsigned i, const unsigned n) {
+    if (tx == nullptr) return 0xFFFF;
+    unsigned w = tx[ 2*i ] << 24;
+    if ((2*i + 1) < n) w |= tx[ 2*i + 1 ] << 16;
+    asm("bitrev %0,%1":"=r"(w):"r"(w));
+    return w;
+}
+
+void XCSpiMaster::transferBlock(const unsigned char * tx, unsigned char * rx, const unsigned n, const bool release) {
+    if (n == 0) return;
+    const unsigned words = (n + 1) / 2;
+    const unsigned last = (n & 1) ? 8 : 16;     //bits in the last word
+    unsigned queued = 0;
+    select();
+    start();
+    for (unsigned k = 0; k < words; k++) {
+        //keep 2 words queued : the port moves to the next one without gap while the previous is read back
+        while ((queued < words) && (queued < k + 2)) {
+            const unsigned w = spiWord(tx, queued, n);
+            if (++queued < words) put(w, 16);
+            else { put(w, last); finish((w >> (last - 1)) & 1); }
+        }
+        unsigned r = get((k == words - 1) ? last : 16);
+        if (rx) {
+            asm("bitrev %0,%1":"=r"(r):"r"(r));
+            rx[ 2*k ] = r >> 24;
+            if ((2*k + 1) < n) rx[ 2*k + 1 ] = r >> 16; }
+    }
+    if (release) deselect();
+}
+
+unsigned char * XCSpiStream::acquire() {
+    while (len[ produce ]) XCSchedulerYield();      //returns immediately if no scheduler
+    return buf[ produce ];
+}
+
+void XCSpiStream::post(const unsigned n) {
+    if (n == 0) { ended = true; return; }
+    asm volatile("":::"memory");   //buffer written before being posted
+    len[ produce ] = n;
+    produce ^= 1;
+}
+
+void XCSpiStream::run(XCSpiMaster & spi, unsigned char * rx, XCSpiStreamRx_t * fn, void * arg) {
+    if (rx && (fn == nullptr)) __builtin_trap();    //each block would overwrite the previous one
+    spi.select();
+    while (1) {
+        unsigned n = len[ consume ];
+        if (n == 0) {
+            if (ended) break;
+            XCSchedulerYield();
+            continue; }
+        spi.transferBlock(buf[ consume ], rx, n, false);
+        asm volatile("":::"memory");
+        len[ consume ] = 0;
+        consume ^= 1;
+        if (rx) fn(arg, rx, n);     //the producer is already filling the buffer just sent
+    }
+    spi.deselect();
+    ended = false;
+}
+
+void XCQSpiMaster::init(const bool xcore) {
+    busInit(xcore);
+    sio.enable().setClock(clk).setBuffered().setTransferWidth(32);
+    if (loop) loop->enable().setClock(clk).setBuffered().setTransferWidth(32);
+    busStart();
+    sio.out(0);
+}
+
+void XCQSpiMaster::stop() {
+    sio.free();
+    if (loop) loop->free();
+    busStop();
+}
+
+//new time base for sclk and sio, few slots ahead
+void XCQSpiMaster::begin() {
+    acc = clkAcc = slots = total = ddrCount = last = 0;
+    t0 = (portTime() + 16) & 0xFFFF;
+    sclk.setTriggerTime(t0);
+    sio.setTriggerTime(t0);
+    if (loop) loop->clrBuffer();
+}
+
+//queue the slots built so far, sio and sclk always receive the same number of slots
+void XCQSpiMaster::flush() {
+    if (slots == 0) return;
+    if (slots == 8) sio.out(acc); else sio.outPartialWord(acc, 4*slots);
+    sclk.outPartialWord(clkAcc, slots);
+    total += slots;
+    acc = clkAcc = slots = 0;
+}
+
+//one nibble on 2 slots. sdr : sclk (idle, active) or (active, idle) as XCSpi modes.
+//ddr : sclk changes in the middle of each nibble, alternately to active and to idle
+void XCQSpiMaster::putNibble(const unsigned v, const bool ddr) {
+    unsigned c;
+    if (ddr) {
+        c = (ddrCount++ & 1) ? 1 : 2;       //(idle, active) then (active, idle) for cpol 0
+        if (mode & 2) c ^= 3;
+    } else c = pattern & 3;
+    last = v;
+    acc |= (v * 0x11) << (4*slots);
+    clkAcc |= c << slots;
+    slots += 2;
+    if (slots == 8) flush();
+}
+
+//msb first, lanes bits per nibble. single lane writes on SIO0
+void XCQSpiMaster::putByte(const unsigned b, const unsigned lanes, const bool ddr) {
+    const unsigned mask = (1 << lanes) - 1;
+    for (int shift = 8 - lanes; shift >= 0; shift -= lanes)
+        putNibble((b >> shift) & mask, ddr);
+}
+
+//command and address phases
+void XCQSpiMaster::header(const command & c, const unsigned addr) {
+    putByte(c.code, c.codeLanes, false);
+    for (int i = c.addrBytes - 1; i >= 0; i--)
+        putByte((addr >> (8*i)) & 0xFF, c.addrLanes, c.ddr);
+}
+
+//second slot of each of the 4 nibbles of a word
+static inline unsigned qspiNibble(const unsigned w, const unsigned k) { return (w >> (8*k + 4)) & 15; }
+
+//the 4 nibbles of a captured word, as driven on the lanes used
+static void echoWord(const unsigned w, const unsigned lanes, unsigned char * echo, unsigned & done, const unsigned n,
+                     unsigned & bits, unsigned & nbits) {
+    for (unsigned k = 0; k < 4; k++) {
+        bits = (bits << lanes) | (qspiNibble(w, k) & ((1 << lanes) - 1));
+        nbits += lanes;
+        if (nbits == 8) { if (done < n) echo[ done++ ] = bits; bits = nbits = 0; } }
+}
+
+void XCQSpiMaster::read(const command & c, const unsigned addr, unsigned char * rx, const unsigned n) {
+    select();
+    begin();
+    header(c, addr);
+    flush();
+    sio.sync();         //sclk stays on its last level until the read starts, as clock stretching
+    sclk.sync();
+    //free running sclk pattern from the dummy cycles to the end of data
+    const unsigned pat = c.ddr ? ((mode & 2) ? 0x99999999 : 0x66666666) : pattern;
+    const unsigned dummySlots = c.ddr ? 4*c.dummy : 2*c.dummy;
+    const unsigned words = (n * 2 * (8 / c.dataLanes) + 7) / 8;
+    sio.clrBuffer();
+    unsigned t = (portTime() + 16) & 0xFFFF;
+    sclk.setTriggerTime(t);
+    sio.setTriggerTime((t + dummySlots) & 0xFFFF);
+    sclk.out(pat); sclk.out(pat);
+    unsigned queued = 2;
+    unsigned bits = 0, nbits = 0, done = 0;
+    const unsigned lanes = c.dataLanes;
+    for (unsigned k = 0; k < words; k++) {
+        const unsigned w = sio.in();
+        if (lanes == 4) {
+            rx[ done++ ] = (qspiNibble(w, 0) << 4) | qspiNibble(w, 1);
+            if (done < n) rx[ done++ ] = (qspiNibble(w, 2) << 4) | qspiNibble(w, 3);
+        } else for (unsigned i = 0; (i < 4) && (done < n); i++) {
+            const unsigned v = qspiNibble(w, i);
+            bits = (bits << lanes) | ((lanes == 2) ? (v & 3) : ((v >> 1) & 1));  //single lane reads SIO1
+            nbits += lanes;
+            if (nbits == 8) { rx[ done++ ] = bits; bits = nbits = 0; }
+        }
+        //one sclk word of 32 slots is finished every 4 sio words, keep 2 queued without blocking
+        const unsigned slot = dummySlots + 8*(k + 1);
+        while ((32*(queued - 1) <= slot) && (32*queued < dummySlots + 8*words + 32)) { sclk.out(pat); queued++; }
+    }
+    //drop the remaining clocks and back to idle level
+    sclk.clrBuffer();
+    sclk.out(idle());
+    deselect();
+}
+
+void XCQSpiMaster::write(const command & c, const unsigned addr, const unsigned char * tx, const unsigned n, unsigned char * echo) {
+    select();
+    begin();
+    header(c, addr);
+    for (unsigned i = 0; i < c.dummy; i++) {
+        putNibble(0, c.ddr);
+        if (c.ddr) putNibble(0, true); }
+    //the loopback port captures from the first data slot
+    const bool capture = (loop != nullptr) && (echo != nullptr);
+    const unsigned start = total + slots;
+    const unsigned lanes = c.dataLanes;
+    const unsigned echoWords = (n * 2 * (8 / lanes) + 7) / 8;
+    unsigned echoed = 0, bits = 0, nbits = 0, done = 0;
+    if (capture) loop->setTriggerTime((t0 + start) & 0xFFFF);
+    for (unsigned i = 0; i < n; i++) {
+        const unsigned before = total;
+        putByte(tx[ i ], lanes, c.ddr);
+        //read back the captured words already complete, one at most between 2 flushes
+        if (capture && (total != before)) while ((echoed < echoWords) && (start + 8*(echoed + 1) + 8 <= total)) {
+            echoWord(loop->in(), lanes, echo, done, n, bits, nbits);
+            echoed++; }
+    }
+    //cpha 0 ends with sclk active, one more slot at idle level
+    if (((mode & 1) == 0) && !c.ddr) {
+        acc |= last << (4*slots);
+        clkAcc |= (pattern & 1) << slots;
+        slots++; }
+    flush();
+    while (capture && (echoed < echoWords)) {
+        echoWord(loop->in(), lanes, echo, done, n, bits, nbits);
+        echoed++; }
+    deselect();
+}
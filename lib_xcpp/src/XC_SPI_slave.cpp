@@ -0,0 +1,96 @@
+#include <xs1.h>
+#include "XC_scheduler.h"
+#include "XC_SPI_slave.hpp"
+
+XCSpiSlave::XCSpiSlave(XCPort &sc, XCPort &mo, XCPort &c, XCClock &cb, unsigned char * r, const unsigned size) :
+    sclk(sc), mosi(mo), cs(c), clk(cb), frames(0), received(0), dropped(0),
+    ring(r), mask(size - 1), head(0), tail(0), stopping(false) {
+    if (size & (size - 1)) __builtin_trap();    //power of 2 only
+    if ((size < 4) || ((unsigned)r & 3)) __builtin_trap();  //full words are stored at once, see push
+}
+
+void XCSpiSlave::init(const unsigned mode) {
+    sclk.enable();
+    //with cpol 1 the pin is inverted, so the leading edge is always a rising edge for the clock block
+    if (mode & 2) sclk.setInvert();
+    clk.enable().setSourcePort(sclk);
+    mosi.enable().setClock(clk).setBuffered().setTransferWidth(32);
+    //cpha 1 samples on the trailing edge
+    if (mode & 1) mosi.setSampleFallingEdge(); else mosi.setSampleRisingEdge();
+    cs.enable();
+    clk.start();
+}
+
+//store the first bytes of a word received lsb first, the first bit being the msb of the first byte
+void XCSpiSlave::push(unsigned w, const unsigned bytes) {
+    asm("bitrev %0,%1 ; byterev %0,%0":"=r"(w):"r"(w));
+    const unsigned h = head;
+    const unsigned free = mask + 1 - (h - tail);
+    if (free < bytes) { dropped += bytes; return; }
+    if ((bytes == 4) && ((h & 3) == 0))
+        *(unsigned *)&ring[ h & mask ] = w;     //ring is word aligned and a multiple of 4
+    else for (unsigned i = 0; i < bytes; i++, w >>= 8) ring[ (h + i) & mask ] = w;
+    asm volatile("":::"memory");    //data written before being published
+    head = h + bytes;
+    received += bytes;
+}
+
+//one chip select period : mosi words until cs goes back high, then the remaining bits
+void XCSpiSlave::frame() {
+    enum { SEL_MOSI = 1, SEL_CS };
+    mosi.setSelect(SEL_MOSI).setEvent();
+    cs.setSelect(SEL_CS);
+    cs.setTriggerInEqual(1);
+    cs.setEvent();
+    bool active = true;
+    while (active) {
+        switch (XC::selectWait()) {
+        case SEL_MOSI:
+            push(mosi.in(), 4);
+            break;
+        case SEL_CS:
+            cs.in();
+            active = false;
+            break;
+        }
+    }
+    mosi.clrEvent();
+    cs.clrEvent();
+    //bits received since the last full word, in the msb part of the last input
+    unsigned bits = mosi.endin();
+    while (bits >= 32) { push(mosi.in(), 4); bits -= 32; }
+    if (bits >= 8) push(mosi.in() >> (32 - bits), bits / 8);
+    frames++;
+}
+
+void XCSpiSlave::run() {
+    stopping = false;
+    while (stopping == false) {
+        //clear mosi while cs is high, so no bit of the frame is lost after the falling edge
+        mosi.clrBuffer();
+        //frame start on chip select falling edge
+        cs.waitEqual(0);
+        if (stopping) break;
+        frame();
+    }
+    cs.clrTriggerIn();
+}
+
+unsigned XCSpiSlave::read(unsigned char * dst, const unsigned max) {
+    const unsigned t = tail;
+    unsigned n = head - t;
+    if (n > max) n = max;
+    for (unsigned i = 0; i < n; i++) dst[ i ] = ring[ (t + i) & mask ];
+    asm volatile("":::"memory");    //data copied before being released
+    tail = t + n;
+    return n;
+}
+
+void XCSpiSlave::waitBlock(unsigned char * dst, const unsigned n) {
+    unsigned done = 0;
+    while (done < n) {
+        unsigned got = read(dst + done, n - done);
+        if (got == 0) XCSchedulerYield();   //returns immediately if no scheduler
+        done += got;
+    }
+}
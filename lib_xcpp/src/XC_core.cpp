@@ -1,6 +1,7 @@
 #include <xs1.h>
 #include <platform.h>
 #include "XC_core.hpp"
+#include "XC_scheduler.h"
 
 namespace XC {
     //zero or the tileID once an task is about to started.
@@ -21,11 +22,38 @@ namespace XC {
     unsigned micros_ticks_factor  = 1UL << micros_ticks_prediv;
     const int millis_prediv = 8;
     unsigned millis_factor = (1ULL << (32+millis_prediv))/100000ULL;    //10995116
+    //ticks, micros and millis when the factors were last changed, so conversions stay continuous
+    static long long rebaseTicks, rebaseMicros, rebaseMillis;
+    //odd while setReferenceHz updates the rebase values and the factors, incremented twice per change :
+    //micros and millis retry when it was odd or has changed during their computation (seqlock).
+    //0 as long as the frequency was never changed : micros and millis then keep their single conversion
+    static volatile unsigned rebaseSeq;
+
+    //msb of the 64 bits ticks multiplied by a 32 bits factor
+    static inline long long ticksScale(const long long ticks, const unsigned factor, const unsigned prediv) {
+        LongLong_t local = { .ll = ticks };
+        local.ull >>= prediv;
+        XC_UNUSED unsigned temp;
+        asm("lmul %0,%1,%2,%3,%4,%5":"=r"(local.ulh.lo),"=r"(temp):"r"(local.ulh.lo),"r"(factor),"r"(0),"r"(0));
+        asm("lmul %0,%1,%2,%3,%4,%5":"=r"(local.ulh.hi),"=r"(local.ulh.lo):"r"(local.ulh.hi),"r"(factor),"r"(0),"r"(local.ulh.lo));
+        return local.ll;
+    }
 
     //this must be called to set the referenceHz when PLL is changed dynamically
     void setReferenceHz(unsigned refHz) {
+#if XC_FIXED_REFERENCE_HZ
+        //conversions are compiled for XC_REFERENCE_HZ only
+        if (refHz && (refHz != XC_REFERENCE_HZ)) __builtin_trap();
+#endif
         if (refHz != referenceHz) {
             if (refHz == 0) refHz = PLATFORM_REFERENCE_HZ;
+            rebaseSeq++;
+            asm volatile("":::"memory");
+            //time elapsed so far is converted with the previous factors
+            long long now = getTime64();
+            rebaseMicros += ticksScale(now - rebaseTicks, micros_factor, 0);
+            rebaseMillis += ticksScale(now - rebaseTicks, millis_factor, millis_prediv);
+            rebaseTicks = now;
             referenceHz = refHz;
             unsigned long long val = lmulu(PLATFORM_REFERENCE_HZ,(1ULL << 32)/100ULL).ull;
             micros_factor = ldivu(val,refHz);
@@ -33,41 +61,105 @@ namespace XC {
             millis_factor = ldivu(val,refHz);
             val = lmulu(PLATFORM_REFERENCE_HZ, 1UL << micros_ticks_prediv).ull;
             micros_ticks_factor = ldivu(val,refHz);
+            asm volatile("":::"memory");
+            rebaseSeq++;
         }
     }
 
-    //software lock is used to protect this code from simultaneous multi core attempt
-    //XCSWLock getTime64Lock;
-    //this will store the latest 64 bit time computed
+    //this will store the latest 64 bit time computed, accessed only with LDD/STD (see getTime64)
     volatile LongLong_t getTime64Ticks;
 
 
+    //scheduler task version of the keeper, sleeping between refreshes
+    extern "C" void XCtime64KeeperTask(unsigned param) {
+        while (1) { XCSchedulerYieldDelay(1 << 30); getTime64(); }
+    }
+
+    //stack of the keeper thread, its loop only waits on its timer and calls getTime64
+    static unsigned long long time64KeeperStack[ 16 ];
+    static unsigned time64Timer;    //timer of the keeper thread, 1 for the keeper task, 0 when no keeper
+
+    //keeper thread : paused on its timer, refresh the snapshot every 2^30 ticks (10.7s at 100MHz)
+    static void time64Keeper() {
+        int time = getTime();
+        while (1) {
+            time += 1 << 30;
+            XC_UNUSED int now;
+            asm volatile("setc res[%1], 9 ; setd res[%1], %2 ; in %0, res[%1]":"=r"(now):"r"(time64Timer),"r"(time));
+            getTime64();
+        }
+    }
+
+    void startTime64Keeper() {
+        if (time64Timer) return;
+        unsigned tmr = getRessource(TYPE_TIMER);
+        unsigned thr = getRessource(TYPE_THREAD);
+        if ((tmr == 0) || (thr == 0)) __builtin_trap();
+        time64Timer = tmr;
+        getTime64();
+        //unsynchronized thread, started immediately and never joined
+        asm volatile(
+            "ldap r11, %c2 ; init t[%0]:pc, r11 \n\t"
+            "init t[%0]:sp, %1 \n\t"
+            "ldaw r11, dp[0] ; init t[%0]:dp, r11 \n\t"
+            "ldaw r11, cp[0] ; init t[%0]:cp, r11 \n\t"
+            "start t[%0]"
+            ::"r"(thr),"r"(&time64KeeperStack[ 15 ]),"i"(time64Keeper):"r11","memory");
+    }
+
+    void startTime64KeeperTask() {
+        if (time64Timer) return;
+        time64Timer = 1;    //no more keeper on this tile
+        getTime64();
+        XCSchedulerCreateTask(XCtime64KeeperTask);
+    }
+
+#if XC_FIXED_REFERENCE_HZ == 0
     //return the real time 64 bits timer value divided by 100 (depending on PLL).
     //return as "signed long long" is a choice in order to be abble to compare futur and actual easily
     //the number will never be negative nor reach 63 bit overflow as this would represent 5800 years of continuous execution
     long long micros(){ 
-        LongLong_t local = { .ll = getTime64() };
-        XC_UNUSED unsigned temp;
-        asm("lmul %0,%1,%2,%3,%4,%5":"=r"(local.ulh.lo),"=r"(temp):"r"(local.ulh.lo),"r"(micros_factor),"r"(0),"r"(0));
-        asm("lmul %0,%1,%2,%3,%4,%5":"=r"(local.ulh.hi),"=r"(local.ulh.lo):"r"(local.ulh.hi),"r"(micros_factor),"r"(0),"r"(local.ulh.lo));
-        return local.ll;
+        unsigned seq;
+        long long us;
+        if (rebaseSeq == 0) {
+            //fast path, valid if no change has started meanwhile
+            us = ticksScale(getTime64(), micros_factor, 0);
+            asm volatile("":::"memory");
+            if (rebaseSeq == 0) return us; }
+        do { seq = rebaseSeq;
+            asm volatile("":::"memory");
+            us = rebaseMicros + ticksScale(getTime64() - rebaseTicks, micros_factor, 0);
+            asm volatile("":::"memory");
+        } while ((seq & 1) || (seq != rebaseSeq));
+        return us;
     }
 
     //same for milliseconds
     long long millis() { 
-        LongLong_t local = { .ll = getTime64() };
-        local.ull >>= millis_prediv;
-        XC_UNUSED unsigned temp;
-        asm("lmul %0,%1,%2,%3,%4,%5":"=r"(local.ulh.lo),"=r"(temp):"r"(local.ulh.lo),"r"(millis_factor),"r"(0),"r"(0));
-        asm("lmul %0,%1,%2,%3,%4,%5":"=r"(local.ulh.hi),"=r"(local.ulh.lo):"r"(local.ulh.hi),"r"(millis_factor),"r"(0),"r"(local.ulh.lo));
-        return local.ll;
+        unsigned seq;
+        long long ms;
+        if (rebaseSeq == 0) {
+            ms = ticksScale(getTime64(), millis_factor, millis_prediv);
+            asm volatile("":::"memory");
+            if (rebaseSeq == 0) return ms; }
+        do { seq = rebaseSeq;
+            asm volatile("":::"memory");
+            ms = rebaseMillis + ticksScale(getTime64() - rebaseTicks, millis_factor, millis_prediv);
+            asm volatile("":::"memory");
+        } while ((seq & 1) || (seq != rebaseSeq));
+        return ms;
     }
+#endif
 
     int microsToTicks(unsigned us) {
+#if XC_FIXED_REFERENCE_HZ
+        return microsToTicksFixed<>(us);
+#else
         long long val = lmulu(micros_ticks_factor,us).ll;
         lsats(val,micros_ticks_prediv);
         int ticks = lextract(val,micros_ticks_prediv);
         return ticks;
+#endif
     }
 
     void delayMicros(unsigned delaymicros) { 
@@ -0,0 +1,62 @@
+#include <xs1.h>
+#include "XC_core.hpp"
+#include "XC_coroutine.hpp"
+
+int XCCoroutineRunner::pass(unsigned & flags) {
+    int earliest = 0;
+    flags = 0;
+    count = 0;
+    XCCoroutine ** pp = &first;
+    while (XCCoroutine * co = *pp) {
+        if (co->ready()) {
+            flags |= 1;
+            if (co->step() == false) {
+                //ended : remove it from the list and give it back to its arena.
+                //coroutines added during the step are in front of it when pp is &first
+                while (*pp != co) pp = &(*pp)->next;
+                *pp = co->next;
+                if (co->arena) co->arena->release(co);
+                continue; }
+        }
+        if (co->coWait == XCCoroutine::RESOURCE) {
+            flags |= 2;
+            unsigned i = 0;
+            while ((i < count) && (resources[ i ] != co->coRes)) i++;
+            if (i == count) {
+                if (count < XC_COROUTINE_WAIT_MAX) resources[ count++ ] = co->coRes; else flags |= 8; } }
+        else if (co->coWait == XCCoroutine::TIME) {
+            if (((flags & 4) == 0) || ((co->coTime - earliest) < 0)) earliest = co->coTime;
+            flags |= 4; }
+        pp = &co->next;
+    }
+    return earliest;
+}
+
+void XCCoroutineRunner::run() {
+    while (first) {
+        unsigned flags;
+        int earliest = pass(flags);
+        if (flags == 4) XCSchedulerYieldUntil(earliest);    //only deadlines : sleep until the first one
+        else if ((flags & ~4) == 2) {
+            //resources, and maybe deadlines : sleep until the first event, the timer giving the earliest deadline
+            unsigned n = count;
+            if (flags & 4) {
+                if (timer == 0) timer = XC::getRessource(XC::TYPE_TIMER);
+                if (timer == 0) __builtin_trap();
+                asm volatile("setc res[%0], 9 ; setd res[%0], %1"::"r"(timer),"r"(earliest));
+                resources[ n++ ] = timer; }
+            XCSchedulerYieldResources(resources, n);
+        }
+        else XCSchedulerYield();                            //a coroutine is ready, or too many resources to wait on
+    }
+}
+
+//scheduler task entry point, param is the runner
+extern "C" void XCCoroutineRunnerTask(unsigned runner) {
+    ((XCCoroutineRunner *)runner)->run();
+}
+
+XCStaskPtr_t XCCoroutineRunner::start(const unsigned stackWords, const unsigned priority) {
+    //stack size cannot be computed from .nstackwords as steps are called indirectly
+    return XCSchedulerCreateTaskPriority_(XC_ADDRESS(XCCoroutineRunnerTask), stackWords, (unsigned)"coroutines", (unsigned)this, priority);
+}
@@ -0,0 +1,70 @@
+#include <xs1.h>
+#include "XC_governor.hpp"
+
+XCGovernor::XCGovernor(const unsigned * pll, const unsigned n, const unsigned up, const unsigned down, const unsigned hold) :
+    points(pll), count(n), current(n - 1), below(0), cores(0), lastTime(0), windowStarted(false), listeners(0),
+    upPercent(up), downPercent(down), holdSamples(hold), transitions(0), dryRun(false) {
+    if (n == 0) __builtin_trap();
+}
+
+void XCGovernor::addListener(XC::voidFuncVoid_t * fn, void * arg) {
+    if (listeners >= XC_GOVERNOR_LISTENERS) __builtin_trap();
+    listenerFn[ listeners ] = fn;
+    listenerArg[ listeners ] = arg;
+    listeners++;
+}
+
+unsigned XCGovernor::step(const unsigned load) {
+    if (load > upPercent) {
+        below = 0;
+        if (current < (count - 1)) return current + 1;
+    } else if (load < downPercent) {
+        if (++below >= holdSamples) {
+            below = 0;
+            if (current > 0) return current - 1; }
+    } else below = 0;
+    return current;
+}
+
+void XCGovernor::setPoint(const unsigned index) {
+    if ((index >= count) || (index == current)) return;
+    current = index;
+    transitions++;
+    if (dryRun) return;
+    unsigned ticks = XC::PLL::writeValue(points[ index ]);
+    XC::PLL::stabilize();
+    if (ticks) XC::setReferenceHz(ticks);
+    for (unsigned i = 0; i < listeners; i++) listenerFn[ i ](listenerArg[ i ]);
+    //start a new measurement window
+    startWindow();
+}
+
+//watched threads, the calling one if none given
+unsigned XCGovernor::watched() const {
+    return cores ? cores : (1 << XC::getid());
+}
+
+void XCGovernor::startWindow() {
+    const unsigned mask = watched();
+    for (unsigned i = 0; i < 8; i++) if (mask & (1 << i)) lastIdle[ i ] = XCSchedulerIdleTicksOf(i);
+    lastTime = XC::getTime();
+    windowStarted = true;
+}
+
+unsigned XCGovernor::update() {
+    unsigned time = XC::getTime();
+    unsigned elapsed = time - lastTime;
+    unsigned load = 0;
+    if (windowStarted && elapsed) {
+        //the least idle thread gives the load
+        const unsigned mask = watched();
+        unsigned idleMin = elapsed;
+        for (unsigned i = 0; i < 8; i++) if (mask & (1 << i)) {
+            unsigned idleElapsed = XCSchedulerIdleTicksOf(i) - lastIdle[ i ];
+            if (idleElapsed < idleMin) idleMin = idleElapsed; }
+        load = 100 - (unsigned)(((unsigned long long)idleMin * 100) / elapsed);
+    } else load = upPercent;    //first call, no window yet : keep the current point
+    startWindow();
+    setPoint(step(load));
+    return load;
+}
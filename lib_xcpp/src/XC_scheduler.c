@@ -16,71 +16,681 @@
  */
 
 #include <xs1.h>            //for get_logical_core_id()
-#include <stdlib.h>         //for malloc
+#include <stdlib.h>
 #if defined(DEBUG_PRINT_ENABLE) && (DEBUG_PRINT_ENABLE == 1)
 #include "debug_print.h"    //xmos standard library
 #else
 #define debug_printf(...)
 #endif
 #include "XC_scheduler.h"
+#include "XC_stackpool.h"   //tcb and stack are allocated in the default stack pool
 
 
 //a task-list per thread/core id, predefined for max 8 core-id
 XCStask_t    mainTcbArray[8];
-XCStaskPtr_t threadArray[8] = { 0, 0, 0, 0, 0, 0, 0, 0 };
+XCSthread_t  threadArray[8];
+
+#if defined(XC_SCHEDULER_STATS) && (XC_SCHEDULER_STATS == 1)
+#define XCS_STATS(...) __VA_ARGS__
+//scheduling latency histogram per thread
+static unsigned latencyArray[8][ XCS_LATENCY_BINS ];
+#else
+#define XCS_STATS(...)
+#endif
+
+//table of timer resources allocated to each thread (by xC runtime or by XCTimer::getLocal)
+extern volatile unsigned __timers[8];
+
+//return the timer resource of the current thread, allocated if not yet done
+static unsigned XCSgetTimer() {
+    unsigned ID = get_logical_core_id();
+    unsigned tmr = __timers[ ID ];
+    if (tmr == 0) { 
+        asm volatile("getr %0, 1":"=r"(tmr));
+        __timers[ ID ] = tmr; }
+    return tmr;
+}
+
+//defined in XC_schedulerYield.S : enable events in the thread and return the environment value
+//of the resource generating the event, or 0 if none. if wait is non zero, block until an event occurs
+unsigned XCSchedulerWaitEvent_(unsigned wait);
+
+//set the resource vector to the scheduler event entry point, and its environment value
+static void XCSarm(unsigned res, unsigned env) {
+    asm volatile(
+        "\n\t   ldap r11, XCSchedulerEvent_"
+        "\n\t   setv res[%0], r11"
+        "\n\t   add  r11, %1, 0"
+        "\n\t   setev res[%0], r11"
+        :: "r"(res), "r"(env) : "r11");
+}
+
+//block the hardware thread on its timer until the given time is reached
+static void XCSwaitTime(XCSthread_t * thread, const int time) {
+    unsigned tmr = XCSgetTimer();
+    int start = XCS_GET_TIME();
+    int end;
+    asm volatile(
+        "\n\t   setc res[%1], 9"                //condition after
+        "\n\t   setd res[%1], %2"               //with the target time
+        "\n\t   in   %0, res[%1]"               //wait
+        "\n\t   setc res[%1], 1"                //remove condition, as expected by XCTimer::getLocal
+        : "=&r"(end) : "r"(tmr), "r"(time) : "memory" );    //wake lists may be changed by other threads meanwhile
+    thread->idleTicks += end - start;
+}
+
+//insert a task at the end of the round robin list of its priority level
+static void XCSreadyInsert(XCSthread_t * thread, XCStaskPtr_t tcb) {
+    const unsigned level = tcb->priority;
+    XCStaskPtr_t pos = thread->ready[ level ];
+    if (pos == 0) { 
+        tcb->next = tcb->prev = tcb;
+        thread->ready[ level ] = tcb;
+        thread->readyMask |= 1 << level; }
+    else {
+        tcb->next = pos;
+        tcb->prev = pos->prev;
+        pos->prev->next = tcb;
+        pos->prev = tcb;
+        //running task was alone in this level, so the new one comes next
+        if (pos == thread->current) thread->ready[ level ] = tcb; }
+    tcb->state = XCS_READY;
+    XCS_STATS( tcb->readyTime = XCS_GET_TIME(); )
+}
+
+//remove a task from the round robin list of its level. its next and prev pointers are then free for other lists
+static void XCSreadyRemove(XCSthread_t * thread, XCStaskPtr_t tcb) {
+    const unsigned level = tcb->priority;
+    if (tcb->next == tcb) {
+        thread->ready[ level ] = 0;
+        thread->readyMask &= ~(1 << level);
+    } else {
+        tcb->prev->next = tcb->next;
+        tcb->next->prev = tcb->prev;
+        if (thread->ready[ level ] == tcb) thread->ready[ level ] = tcb->next; }
+}
+
+//return the task to run in the highest ready level, and move this level to its next task
+static XCStaskPtr_t XCSreadyNext(XCSthread_t * thread) {
+    unsigned level;
+    asm("clz %0,%1":"=r"(level):"r"(thread->readyMask));
+    level = 31 - level;
+    XCStaskPtr_t tcb = thread->ready[ level ];
+    thread->ready[ level ] = tcb->next;
+    return tcb;
+}
+
+//insert a task in the sleeping list, ordered by timeAfter (earliest first)
+static void XCSsleepInsert(XCSthread_t * thread, XCStaskPtr_t tcb) {
+    XCStaskPtr_t * pp = &thread->sleep;
+    while ((*pp) && (((*pp)->timeAfter - tcb->timeAfter) <= 0)) pp = &((*pp)->next);
+    tcb->next = *pp;
+    *pp = tcb;
+}
+
+//insert a task at the begining of the waiting list, and set the vector of each of its resources.
+//a resource has a single vector and environment : a second task waiting on it is a fatal error
+static void XCSwaitInsert(XCSthread_t * thread, XCStaskPtr_t tcb) {
+    for (XCStaskPtr_t t = thread->wait; t; t = t->next)
+        for (unsigned i = 0; i < t->resourceCount; i++)
+            for (unsigned j = 0; j < tcb->resourceCount; j++)
+                if (t->resources[ i ] == tcb->resources[ j ]) __builtin_trap();
+    for (unsigned j = 0; j < tcb->resourceCount; j++) XCSarm(tcb->resources[ j ], (unsigned)tcb);
+    tcb->prev = 0;
+    tcb->next = thread->wait;
+    if (tcb->next) tcb->next->prev = tcb;
+    thread->wait = tcb;
+}
+
+//remove a task from the waiting list
+static void XCSwaitRemove(XCSthread_t * thread, XCStaskPtr_t tcb) {
+    if (tcb->prev) tcb->prev->next = tcb->next; else thread->wait = tcb->next;
+    if (tcb->next) tcb->next->prev = tcb->prev;
+}
+
+//link a task blocked on a sync object in the blocked list of its thread, with its free next and prev pointers
+static void XCSblockedInsert(XCSthread_t * thread, XCStaskPtr_t tcb) {
+    tcb->prev = 0;
+    tcb->next = thread->blockedList;
+    if (tcb->next) tcb->next->prev = tcb;
+    thread->blockedList = tcb;
+    thread->blocked++;
+}
+
+//remove a task from the blocked list, before inserting it in its ready list
+static void XCSblockedRemove(XCSthread_t * thread, XCStaskPtr_t tcb) {
+    if (tcb->prev) tcb->prev->next = tcb->next; else thread->blockedList = tcb->next;
+    if (tcb->next) tcb->next->prev = tcb->prev;
+    thread->blocked--;
+}
+
+//single hardware lock protecting all sync objects and the wake lists of all threads.
+//taken by the first sync object initialised and given back when the last one is deinitialised,
+//so an application without mutex, semaphore or event flags keeps its 4 hardware locks
+static unsigned XCSsyncLock;
+static unsigned XCSsyncObjects;
+static volatile unsigned XCSsyncGuard;      //software lock for getr/freer, same method as XCSWLock
+
+static void XCSguardAcquire() {
+    unsigned myID = get_logical_core_id() + 1;
+    do { while (XCSsyncGuard) { }; XCSsyncGuard = myID;
+        asm volatile("nop;nop;nop;nop;nop;nop;nop"); }
+    while (XCSsyncGuard != myID);
+}
+static inline void XCSguardRelease() { XCSsyncGuard = 0; }
+static inline void XCSlock()   { asm volatile("in  %0, res[%0]"::"r"(XCSsyncLock):"memory"); }
+static inline void XCSunlock() { asm volatile("out res[%0], %0"::"r"(XCSsyncLock):"memory"); }
+
+//insert in the ready lists the tasks released by other threads
+static void XCSwakeSync(XCSthread_t * thread) {
+    XCSlock();
+    XCStaskPtr_t tcb = thread->wake;
+    thread->wake = 0;
+    XCSunlock();
+    while (tcb) {
+        XCStaskPtr_t next = tcb->syncNext;
+        XCSblockedRemove(thread, tcb);
+        XCSreadyInsert(thread, tcb);
+        tcb = next; }
+}
+
+//time until which the thread can block : the earliest sleeping task, 
+//but not longer than the sync poll period if some tasks are blocked on sync objects
+static int XCSdeadline(XCSthread_t * thread) {
+    if (thread->blocked) {
+        int time = XCS_SET_TIME(XC_SCHEDULER_SYNC_POLL);
+        if (thread->sleep && ((thread->sleep->timeAfter - time) < 0)) time = thread->sleep->timeAfter;
+        return time; }
+    if (thread->sleep == 0) __builtin_trap();   //no more task to run
+    return thread->sleep->timeAfter;
+}
+
+//enable the event of every resource in the waiting list, and collect those which are ready.
+//if block is non zero, the thread waits for the first event, including the thread timer
+//set to the earliest sleeping task. tasks woken up are inserted in their ready list.
+static void XCSwakeEvents(XCSthread_t * thread, const unsigned block) {
+    XCStaskPtr_t tcb;
+    unsigned tmr = 0;
+    int start = 0;
+    asm volatile("clre");
+    for (tcb = thread->wait; tcb; tcb = tcb->next)
+        for (unsigned i = 0; i < tcb->resourceCount; i++) asm volatile("eeu res[%0]"::"r"(tcb->resources[ i ]));
+    if (block) {
+        if (thread->sleep || thread->blocked) {
+            tmr = XCSgetTimer();
+            XCSarm(tmr, (unsigned)thread);
+            asm volatile("setc res[%0], 9 ; setd res[%0], %1 ; eeu res[%0]"::"r"(tmr),"r"(XCSdeadline(thread)));
+        }
+        start = XCS_GET_TIME();
+    }
+    unsigned ev = XCSchedulerWaitEvent_(block);
+    if (block) thread->idleTicks += XCS_GET_TIME() - start;
+    while (ev) {
+        if (ev != (unsigned)thread) {
+            //resume the task whose resource fired, its other resources are disabled too
+            tcb = (XCStaskPtr_t)ev;
+            for (unsigned i = 0; i < tcb->resourceCount; i++) asm volatile("edu res[%0]"::"r"(tcb->resources[ i ]));
+            XCSwaitRemove(thread, tcb);
+            XCSreadyInsert(thread, tcb);
+        } else asm volatile("edu res[%0]"::"r"(tmr));   //thread timer, sleeping tasks are woken up by caller
+        ev = XCSchedulerWaitEvent_(0);
+    }
+    asm volatile("clre");
+    if (tmr) asm volatile("setc res[%0], 1"::"r"(tmr));
+}
+
+//move every task with an elapsed timeAfter into its ready list
+static void XCSwakeUp(XCSthread_t * thread) {
+    XCStaskPtr_t tcb;
+    while ( (tcb = thread->sleep) && XCS_END_TIME(tcb->timeAfter) ) {
+        thread->sleep = tcb->next;
+        XCSreadyInsert(thread, tcb);
+        XCS_STATS( tcb->readyTime = tcb->timeAfter; )
+    }
+}
+
+//called by XCSchedulerYield once the context of the current task is saved.
+//return the task to switch to, or 0 if the main task remains alone (scheduler stopped)
+XCStaskPtr_t XCSchedulerNext_(XCSthread_t * thread) {
+    XCStaskPtr_t current = thread->current;
+#if defined(XC_SCHEDULER_STACK_CHECK) && (XC_SCHEDULER_STACK_CHECK == 1)
+    if (current->stackTop && XCSchedulerStackCheck(current)) XCSchedulerStackOverflow(current);
+#endif
+#if defined(XC_SCHEDULER_STATS) && (XC_SCHEDULER_STATS == 1)
+    int now = XCS_GET_TIME();
+    unsigned run = now - current->runStart;
+    current->runTicks += run;
+    current->yields++;
+    if (run > current->longestRun) current->longestRun = run;
+    if (current->state == XCS_READY) current->readyTime = now;
+#endif
+    if (current->state != XCS_READY) {
+        //current task is leaving the round robin list
+        XCSreadyRemove(thread, current);
+        if (current->state == XCS_SLEEPING) XCSsleepInsert(thread, current);
+        else if (current->state == XCS_WAITING) XCSwaitInsert(thread, current);
+        else if (current->state == XCS_BLOCKED) XCSblockedInsert(thread, current);
+    }
+    while (1) {
+        //written by other threads : volatile read at each iteration
+        if (*(volatile XCStaskPtr_t *)&thread->wake) XCSwakeSync(thread);
+        XCSwakeUp(thread);
+        //poll waiting resources, or block on all of them (and on timer) if no task is ready
+        if (thread->wait) XCSwakeEvents(thread, (thread->readyMask == 0));
+        if (thread->readyMask) break;
+        if (thread->wait) continue;     //timer event, sleeping tasks are woken up at next iteration
+        //all tasks are sleeping or blocked : block the thread on its timer until the earliest one
+        XCSwaitTime(thread, XCSdeadline(thread));
+    }
+    XCStaskPtr_t next = XCSreadyNext(thread);
+    XCStaskPtr_t main = thread->main;
+#if defined(XC_SCHEDULER_ROBIN_MODE) && (XC_SCHEDULER_ROBIN_MODE==0)
+    //systematically go back to main task after a child task of same level, 
+    //then resume the round robin with the selected one
+    if ((current != main) && (next != main) && (main->state == XCS_READY) && (main->priority == next->priority)) {
+        thread->ready[ next->priority ] = next;
+        next = main;
+    }
+#endif
+#if defined(XC_SCHEDULER_STATS) && (XC_SCHEDULER_STATS == 1)
+    now = XCS_GET_TIME();
+    unsigned latency = now - next->readyTime;
+    unsigned bin;
+    asm("clz %0,%1":"=r"(bin):"r"(latency));
+    bin = 32 - bin;
+    if (bin >= XCS_LATENCY_BINS) bin = XCS_LATENCY_BINS-1;
+    latencyArray[ get_logical_core_id() ][ bin ]++;
+    next->runStart = now;
+#endif
+    if ((next == current) && (current == main) && (current->next == current) 
+        && (thread->readyMask == (1 << current->priority)) && (thread->sleep == 0) && (thread->wait == 0)
+        && (thread->blocked == 0)) {
+        //main task is alone, clean up for next yield
+        thread->current = 0;
+        return 0;
+    }
+    thread->current = next;
+    return next;
+}
+
+XCStaskPtr_t XCSchedulerExit_(XCSthread_t * thread) {
+    XCStaskPtr_t current = thread->current;
+    current->state = XCS_ENDED;
+    XCStaskPtr_t next = XCSchedulerNext_(thread);
+    XCStackPoolFree(&XCStackPool, current);
+    if (next == 0) next = thread->main; //back to main, next yield will return 0
+    return next;
+}
 
 //create a TCB record containing task information (SP,PC,param,name...) and allocate stack size
 XCStaskPtr_t XCSchedulerCreateTCB_(const unsigned taskAddress, const unsigned stackSize, const unsigned name, const unsigned param)
 {
-    //convert stacksize to bytes and add tcb size
-    int alloc = (stackSize+1) * 4 + sizeof(XCStask_t);      //compute number of bytes required
-    XCStaskPtr_t tcb = (XCStask_t *)malloc( alloc + 4);     //add 4 as SP points on the highest word where lr is stored before stack pointer is changed
+    //convert stacksize to bytes and add tcb size and guard word
+    int alloc = (stackSize+2) * 4 + sizeof(XCStask_t);      //compute number of bytes required
+    XCStaskPtr_t tcb = (XCStask_t *)XCStackPoolAlloc( &XCStackPool, alloc + 4);    //add 4 as SP points on the highest word where lr is stored before stack pointer is changed
     if (tcb == 0) __builtin_trap();
     tcb->name = (char*)name;
     tcb->param= param;
     tcb->pc   = taskAddress;
     tcb->next = tcb->prev = 0;
+    tcb->timeAfter = 0;
+    tcb->state = XCS_READY;
+    tcb->priority = XCS_PRIORITY_NORMAL;
     //compute top of the stack address, pointing on the last word allocated
     unsigned SP = (unsigned)tcb + alloc;
     tcb->sp = SP & ~7;   //force allignement 8. this may reduce SP by one but alloc includs one more
+    tcb->stackTop = tcb->sp;
+    XCS_STATS( tcb->runTicks = tcb->yields = tcb->longestRun = 0; )
+    //guard at the bottom of the stack, just after the tcb, then paint the stack up to its top
+    unsigned * p = (unsigned *)(tcb + 1);
+    *p++ = XCS_STACK_GUARD;
+    while ((unsigned)p < tcb->sp) *p++ = XCS_STACK_PAINT;
     debug_printf("Create task %s(%d), tcb @ %xh (%d)\n",tcb->name,tcb->param,(unsigned)tcb,(unsigned)tcb);
     return tcb;
 }
 
-//create a task by allocating stack and context and adding context at the end of main thread list
-XCStaskPtr_t XCSchedulerCreateTask_(const unsigned taskAddress, const unsigned stackSize, const unsigned name, const unsigned param)
+//create a task by allocating stack and context and adding it in the list of its priority level
+XCStaskPtr_t XCSchedulerCreateTaskPriority_(const unsigned taskAddress, const unsigned stackSize, const unsigned name, const unsigned param, const unsigned priority)
 {
     unsigned ID = get_logical_core_id();
-    XCStaskPtr_t  mainTcb = &mainTcbArray[ ID ];
-    if (threadArray[ ID ] == 0) { 
+    XCSthread_t * thread = &threadArray[ ID ];
+    if (priority >= XC_SCHEDULER_PRIORITIES) __builtin_trap();
+    if (thread->current == 0) { 
         //main tcb table not yet initialized
-        mainTcb->next = mainTcb->prev = mainTcb;
+        XCStaskPtr_t  mainTcb = &mainTcbArray[ ID ];
+        thread->readyMask = 0;
+        thread->wake = 0;
+        thread->blocked = 0;
+        thread->blockedList = 0;
+        for (int i = 0; i < XC_SCHEDULER_PRIORITIES; i++) thread->ready[ i ] = 0;
         mainTcb->name = "main";
         mainTcb->param = mainTcb->pc = mainTcb->timeAfter = 0;
-        threadArray[ ID ] = mainTcb;
+        mainTcb->priority = XCS_PRIORITY_NORMAL;
+        mainTcb->stackTop = 0;
+        mainTcb->core = ID;
+        XCS_STATS( mainTcb->runTicks = mainTcb->yields = mainTcb->longestRun = 0;
+                   mainTcb->runStart = XCS_GET_TIME(); )
+        thread->main = thread->current = mainTcb;
+        XCSreadyInsert(thread, mainTcb);
     }
-    XCStaskPtr_t current = threadArray[ ID ];
     XCStaskPtr_t tcb =  XCSchedulerCreateTCB_(taskAddress,stackSize,name,param);
-    //insert this task just after the one creating it
-    tcb->next = current->next;          //point on main task to create a loop
-    current->next->prev  = tcb;          //update equivalent to "last"
-    tcb->prev = current;                //equivalent to "last"
-    current->next = tcb;              //set previous task to point on this one
+    tcb->priority = priority;
+    tcb->core = ID;
+    //insert this task at the end of its level, that is just after the one creating it if same level
+    XCSreadyInsert(thread, tcb);
     return tcb;
 }
 
+//create a task with normal priority level
+XCStaskPtr_t XCSchedulerCreateTask_(const unsigned taskAddress, const unsigned stackSize, const unsigned name, const unsigned param)
+{
+    return XCSchedulerCreateTaskPriority_(taskAddress, stackSize, name, param, XCS_PRIORITY_NORMAL);
+}
+
+//change the priority level of a task. if the task is ready, it is moved at the end of its new level
+void XCSchedulerSetPriority(XCStaskPtr_t tcb, const unsigned priority) {
+    if (priority >= XC_SCHEDULER_PRIORITIES) __builtin_trap();
+    XCSthread_t * thread = &threadArray[ get_logical_core_id() ];
+    if ((thread->current == 0) || (tcb->state != XCS_READY)) { tcb->priority = priority; return; }
+    XCSreadyRemove(thread, tcb);
+    tcb->priority = priority;
+    XCSreadyInsert(thread, tcb);
+}
+
+//remove the current task from the round robin list until the given time, and switch to other tasks.
+//if the scheduler is not started, the thread is just blocked on its timer
+XCStaskPtr_t XCSchedulerYieldUntil(const int time) {
+    XCSthread_t * thread = &threadArray[ get_logical_core_id() ];
+    XCStaskPtr_t current = thread->current;
+    if (current == 0) {
+        if (XCS_ONGOING_TIME(time)) XCSwaitTime(thread, time);
+        return 0;
+    }
+    current->timeAfter = time;
+    current->state = XCS_SLEEPING;
+    return XCSchedulerYield();
+}
 
 XCStaskPtr_t XCSchedulerYieldDelay(const int max) {
-    XCStaskPtr_t res;
-    int time = XCS_SET_TIME(max);
-    do  res  = XCSchedulerYield();
-    while  ( XCS_ONGOING_TIME(time) );
-    return res;
+    return XCSchedulerYieldUntil( XCS_SET_TIME(max) );
+}
+
+unsigned XCSchedulerIdleTicks() {
+    return threadArray[ get_logical_core_id() ].idleTicks;
 }
 
+unsigned XCSchedulerIdleTicksOf(const unsigned core) {
+    return *(volatile unsigned *)&threadArray[ core & 7 ].idleTicks;
+}
+
+//remove the current task from the round robin list until one of the resources generates an event, and switch to other tasks.
+//if the scheduler is not started, the thread is just blocked waiting the first event
+XCStaskPtr_t XCSchedulerYieldResources(const unsigned * res, const unsigned n) {
+    XCSthread_t * thread = &threadArray[ get_logical_core_id() ];
+    XCStaskPtr_t current = thread->current;
+    if (current == 0) {
+        asm volatile("clre");
+        for (unsigned i = 0; i < n; i++) {
+            XCSarm(res[ i ], 1);
+            asm volatile("eeu res[%0]"::"r"(res[ i ])); }
+        XCSchedulerWaitEvent_(1);
+        asm volatile("clre");
+        return 0;
+    }
+    current->resources = res;
+    current->resourceCount = n;
+    current->state = XCS_WAITING;
+    return XCSchedulerYield();
+}
+
+XCStaskPtr_t XCSchedulerYieldResource(unsigned res) {
+    XCStaskPtr_t current = threadArray[ get_logical_core_id() ].current;
+    if (current == 0) return XCSchedulerYieldResources(&res, 1);
+    current->resource = res;
+    return XCSchedulerYieldResources(&current->resource, 1);
+}
 
 XCStaskPtr_t XCSchedulerYieldChanend(unsigned ch) {
-    XCStaskPtr_t res;
-    while (!XCStestChan(ch)) res = XCSchedulerYield(); 
+    return XCSchedulerYieldResource(ch);
+}
+
+//scan the painted area from the guard upward, the first modified word gives the deepest stack use
+unsigned XCSchedulerStackPeak(XCStaskPtr_t tcb) {
+    if (tcb->stackTop == 0) return 0;
+    unsigned * p = (unsigned *)(tcb + 1) + 1;
+    while (((unsigned)p < tcb->stackTop) && (*p == XCS_STACK_PAINT)) p++;
+    return (tcb->stackTop - (unsigned)p) / 4;
+}
+
+unsigned XCSchedulerStackCheck(XCStaskPtr_t tcb) {
+    unsigned * guard = (unsigned *)(tcb + 1);
+    return (*guard != XCS_STACK_GUARD) || (tcb->sp <= (unsigned)guard);
+}
+
+__attribute__((weak)) void XCSchedulerStackOverflow(XCStaskPtr_t tcb) {
+    debug_printf("stack overflow in task %s(%d)\n", tcb->name, tcb->param);
+    __builtin_trap();
+}
+
+#if defined(XC_SCHEDULER_STATS) && (XC_SCHEDULER_STATS == 1)
+
+static void XCSstatsCopy(XCStaskStats_t * entry, XCStaskPtr_t tcb) {
+    entry->name = tcb->name;
+    entry->param = tcb->param;
+    entry->priority = tcb->priority;
+    entry->state = tcb->state;
+    entry->runTicks = tcb->runTicks;
+    entry->yields = tcb->yields;
+    entry->longestRun = tcb->longestRun;
+}
+
+//call the function for every task of the thread : ready rings, sleeping, waiting and blocked lists
+static unsigned XCSforEachTask(XCSthread_t * thread, void (*func)(XCStaskPtr_t, void *), void * arg) {
+    unsigned n = 0;
+    XCStaskPtr_t tcb;
+    if (thread->current == 0) return 0;
+    for (unsigned level = 0; level < XC_SCHEDULER_PRIORITIES; level++) {
+        XCStaskPtr_t first = thread->ready[ level ];
+        if (first) { tcb = first; do { func(tcb, arg); n++; tcb = tcb->next; } while (tcb != first); }
+    }
+    for (tcb = thread->sleep; tcb; tcb = tcb->next) { func(tcb, arg); n++; }
+    for (tcb = thread->wait;  tcb; tcb = tcb->next) { func(tcb, arg); n++; }
+    for (tcb = thread->blockedList; tcb; tcb = tcb->next) { func(tcb, arg); n++; }
+    return n;
+}
+
+typedef struct { XCStaskStats_t * table; unsigned max; unsigned n; } XCSsnapshot_t;
+
+static void XCSsnapshotTask(XCStaskPtr_t tcb, void * arg) {
+    XCSsnapshot_t * snap = (XCSsnapshot_t *)arg;
+    if (snap->n < snap->max) XCSstatsCopy(&snap->table[ snap->n++ ], tcb);
+}
+
+static void XCSresetTask(XCStaskPtr_t tcb, void * arg) {
+    tcb->runTicks = tcb->yields = tcb->longestRun = 0;
+}
+
+unsigned XCSchedulerStatsSnapshot(XCStaskStats_t * table, const unsigned max) {
+    XCSsnapshot_t snap = { table, max, 0 };
+    XCSforEachTask(&threadArray[ get_logical_core_id() ], XCSsnapshotTask, &snap);
+    return snap.n;
+}
+
+void XCSchedulerLatencyHistogram(unsigned * hist) {
+    unsigned * src = latencyArray[ get_logical_core_id() ];
+    for (int i = 0; i < XCS_LATENCY_BINS; i++) hist[ i ] = src[ i ];
+}
+
+void XCSchedulerStatsReset() {
+    unsigned ID = get_logical_core_id();
+    XCSforEachTask(&threadArray[ ID ], XCSresetTask, 0);
+    for (int i = 0; i < XCS_LATENCY_BINS; i++) latencyArray[ ID ][ i ] = 0;
+}
+
+void XCSchedulerStatsPrint() {
+    XCStaskStats_t table[ 16 ];
+    unsigned n = XCSchedulerStatsSnapshot(table, 16);
+    for (unsigned i = 0; i < n; i++)
+        debug_printf("%s(%d) prio %d state %d : %d ticks, %d yields, longest %d\n",
+            table[i].name, table[i].param, table[i].priority, table[i].state,
+            table[i].runTicks, table[i].yields, table[i].longestRun);
+    unsigned * hist = latencyArray[ get_logical_core_id() ];
+    for (int i = 0; i < XCS_LATENCY_BINS; i++)
+        if (hist[ i ]) debug_printf("latency < %d ticks : %d\n", 1 << i, hist[ i ]);
+}
+
+#endif //XC_SCHEDULER_STATS
+
+//queue the current task at the end of the sync object. called with the lock taken
+static void XCSblock(XCSsync_t * sync, XCStaskPtr_t tcb) {
+    tcb->syncNext = 0;
+    if (sync->last) sync->last->syncNext = tcb; else sync->first = tcb;
+    sync->last = tcb;
+    tcb->state = XCS_BLOCKED;
+}
+
+//remove the first task blocked on the sync object. called with the lock taken
+static XCStaskPtr_t XCSpop(XCSsync_t * sync) {
+    XCStaskPtr_t tcb = sync->first;
+    if (tcb) {
+        sync->first = tcb->syncNext;
+        if (sync->first == 0) sync->last = 0; }
+    return tcb;
+}
+
+//put back a blocked task in its ready list, directly if it belongs to this thread,
+//or through the wake list of its thread otherwise. called with the lock taken
+static void XCSrelease(XCStaskPtr_t tcb) {
+    XCSthread_t * thread = &threadArray[ tcb->core ];
+    if (tcb->core == get_logical_core_id()) {
+        XCSblockedRemove(thread, tcb);
+        XCSreadyInsert(thread, tcb);
+    } else {
+        tcb->syncNext = thread->wake;
+        thread->wake = tcb; }
+}
+
+//block the current task on the sync object and release the lock. 
+//without scheduler, release the lock and sleep one poll period : caller will check again
+static void XCSwaitSync(XCSsync_t * sync) {
+    XCStaskPtr_t current = threadArray[ get_logical_core_id() ].current;
+    if (current) {
+        XCSblock(sync, current);
+        XCSunlock();
+        XCSchedulerYield();
+    } else {
+        XCSunlock();
+        XCSchedulerYieldDelay(XC_SCHEDULER_SYNC_POLL); }
+}
+
+void XCSchedulerSyncInit(XCSsync_t * sync, const int count) {
+    sync->count = count;
+    sync->owner = sync->first = sync->last = 0;
+    XCSguardAcquire();
+    if (XCSsyncObjects++ == 0) {
+        asm volatile("getr %0, 5":"=r"(XCSsyncLock));
+        if (XCSsyncLock == 0) __builtin_trap(); }
+    XCSguardRelease();
+}
+
+void XCSchedulerSyncDeinit(XCSsync_t * sync) {
+    if (sync->first) __builtin_trap();      //tasks still blocked on the object
+    XCSguardAcquire();
+    if (--XCSsyncObjects == 0) {
+        asm volatile("freer res[%0]"::"r"(XCSsyncLock));
+        XCSsyncLock = 0; }
+    XCSguardRelease();
+}
+
+unsigned XCSchedulerSemTryTake(XCSsync_t * sync) {
+    unsigned res = 0;
+    XCSlock();
+    if (sync->count > 0) { sync->count--; res = 1; }
+    XCSunlock();
     return res;
 }
+
+void XCSchedulerSemTake(XCSsync_t * sync) {
+    while (1) {
+        XCSlock();
+        if (sync->count > 0) { sync->count--; XCSunlock(); return; }
+        XCSwaitSync(sync);
+        //a task released by XCSchedulerSemGive has received the unit
+        if (threadArray[ get_logical_core_id() ].current) return;
+    }
+}
+
+void XCSchedulerSemGive(XCSsync_t * sync) {
+    XCSlock();
+    XCStaskPtr_t tcb = XCSpop(sync);
+    if (tcb) XCSrelease(tcb); else sync->count++;
+    XCSunlock();
+}
+
+void XCSchedulerMutexLock(XCSsync_t * sync) {
+    XCStaskPtr_t current = threadArray[ get_logical_core_id() ].current;
+    if (current && (sync->owner == current)) __builtin_trap();  //not recursive
+    while (1) {
+        XCSlock();
+        if (sync->count > 0) { sync->count = 0; sync->owner = current; XCSunlock(); return; }
+        XCSwaitSync(sync);
+        //a task released by XCSchedulerMutexUnlock is the new owner
+        if (current) return;
+    }
+}
+
+void XCSchedulerMutexUnlock(XCSsync_t * sync) {
+    XCSlock();
+    XCStaskPtr_t tcb = XCSpop(sync);
+    if (tcb) { sync->owner = tcb; XCSrelease(tcb); }
+    else { sync->owner = 0; sync->count = 1; }
+    XCSunlock();
+}
+
+//return the flags matching the mask according to the mode, or 0 if the condition is not met
+static unsigned XCSeventMatch(XCSsync_t * sync, const unsigned mask, const unsigned mode) {
+    unsigned match = sync->count & mask;
+    if (mode & XCS_EVENT_ALL) { if (match != mask) return 0; }
+    if (match && (mode & XCS_EVENT_CLEAR)) sync->count &= ~match;
+    return match;
+}
+
+unsigned XCSchedulerEventWait(XCSsync_t * sync, const unsigned mask, const unsigned mode) {
+    XCStaskPtr_t current = threadArray[ get_logical_core_id() ].current;
+    while (1) {
+        XCSlock();
+        unsigned match = XCSeventMatch(sync, mask, mode);
+        if (match) { XCSunlock(); return match; }
+        if (current) {
+            //mask and mode are kept in the tcb, and the flags received are given back in resource
+            current->resource = mask;
+            current->timeAfter = mode;
+            XCSwaitSync(sync);
+            return current->resource; }
+        XCSwaitSync(sync);
+    }
+}
+
+void XCSchedulerEventSet(XCSsync_t * sync, const unsigned mask) {
+    XCSlock();
+    sync->count |= mask;
+    XCStaskPtr_t * pp = &sync->first;
+    XCStaskPtr_t prev = 0;
+    while (*pp) {
+        XCStaskPtr_t tcb = *pp;
+        unsigned match = XCSeventMatch(sync, tcb->resource, tcb->timeAfter);
+        if (match) {
+            *pp = tcb->syncNext;
+            if (sync->last == tcb) sync->last = prev;
+            tcb->resource = match;
+            XCSrelease(tcb);
+        } else { prev = tcb; pp = &tcb->syncNext; }
+    }
+    XCSunlock();
+}
+
+void XCSchedulerEventClear(XCSsync_t * sync, const unsigned mask) {
+    XCSlock();
+    sync->count &= ~mask;
+    XCSunlock();
+}
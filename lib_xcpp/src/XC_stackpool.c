@@ -0,0 +1,89 @@
+/**
+ * @file XC_stackpool.c
+ * @version 1.0
+ * Copyright (C) 2026, fabriceo
+ * https://github.com/fabriceo
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ */
+
+#include <xs1.h>
+#include <stdlib.h>         //for malloc, as fallback
+#include "XC_stackpool.h"
+
+XCStackPool_t XCStackPool;
+
+#if XC_STACKPOOL_BLOCKS > 0
+static XC_STACKPOOL_BUFFER(XCStackPoolBuffer, XC_STACKPOOL_WORDS, XC_STACKPOOL_BLOCKS);
+
+//the default pool is ready before main and before any par statement
+__attribute__((constructor)) static void XCStackPoolStartup() {
+    XCStackPoolInit(&XCStackPool, XCStackPoolBuffer, XC_STACKPOOL_WORDS, XC_STACKPOOL_BLOCKS);
+}
+#endif
+
+static inline void XCSPacquire(unsigned lock) { asm volatile("in  %0, res[%0]"::"r"(lock):"memory"); }
+static inline void XCSPrelease(unsigned lock) { asm volatile("out res[%0], %0"::"r"(lock):"memory"); }
+
+//the hardware lock of a pool is taken at its first allocation, not at startup.
+//software lock around the getr, same method as XCSWLock
+static volatile unsigned XCSPguard;
+static void XCSPgetLock(XCStackPool_t * pool) {
+    unsigned myID = get_logical_core_id() + 1;
+    do { while (XCSPguard) { }; XCSPguard = myID;
+        asm volatile("nop;nop;nop;nop;nop;nop;nop"); }
+    while (XCSPguard != myID);
+    if (pool->lock == 0) asm volatile("getr %0, 5":"=r"(pool->lock));
+    XCSPguard = 0;
+    if (pool->lock == 0) __builtin_trap();
+}
+
+void XCStackPoolInit(XCStackPool_t * pool, void * buffer, const unsigned words, const unsigned n) {
+    unsigned bytes = ((words + 1) / 2) * 8;
+    //chain all blocks in the free list, last one points on null
+    char * block = (char *)buffer;
+    for (unsigned i = 1; i < n; i++) { *(void **)block = block + bytes; block += bytes; }
+    if (n) *(void **)block = 0;
+    pool->free = n ? buffer : 0;
+    pool->base = buffer;
+    pool->end  = (char *)buffer + bytes * n;
+    pool->blockBytes = bytes;
+    pool->used = pool->highWater = pool->fallbacks = 0;
+}
+
+void * XCStackPoolAlloc(XCStackPool_t * pool, const unsigned bytes) {
+    void * block = 0;
+    if (pool->blockBytes == 0) { pool->fallbacks++; return malloc(bytes); }  //pool not initialised, nothing to protect
+    if (pool->lock == 0) XCSPgetLock(pool);
+    XCSPacquire(pool->lock);
+    if (bytes <= pool->blockBytes) block = pool->free;
+    if (block) {
+        pool->free = *(void **)block;
+        if (++pool->used > pool->highWater) pool->highWater = pool->used;
+    } else pool->fallbacks++;
+    XCSPrelease(pool->lock);
+    if (block) return block;
+    return malloc(bytes);
+}
+
+void XCStackPoolFree(XCStackPool_t * pool, void * block) {
+    if (block == 0) return;
+    if ((block < pool->base) || (block >= pool->end)) { free(block); return; }
+    XCSPacquire(pool->lock);
+    *(void **)block = pool->free;
+    pool->free = block;
+    pool->used--;
+    XCSPrelease(pool->lock);
+}
+
+unsigned XCStackPoolHighWater(XCStackPool_t * pool) {
+    return pool->highWater;
+}
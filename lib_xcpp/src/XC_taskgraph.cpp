@@ -0,0 +1,99 @@
+#include <xs1.h>
+#include "XC_taskgraph.hpp"
+
+namespace XC {
+
+taskGraph::taskGraph(graphNode * n, const unsigned c) : nodes(n), count(c), taken(0), done(0), lock(0), t0(0) {
+    if (c > 32) __builtin_trap();
+    all = (c == 32) ? 0xFFFFFFFF : ((1u << c) - 1);
+    for (unsigned i = 0; i < c; i++)
+        if (nodes[ i ].deps >> i) __builtin_trap();  //dependency not declared before this step
+}
+
+void taskGraph::worker(void * p) { ((taskGraph *)p)->loop(); }
+
+int taskGraph::pick() {
+    int res = -1;
+    if (lock) asm volatile("in %0,res[%0]"::"r"(lock):"memory");
+    unsigned candidates = all & ~taken;
+    for (unsigned i = 0; candidates; i++, candidates >>= 1)
+        if ((candidates & 1) && ((nodes[ i ].deps & done) == nodes[ i ].deps)) {
+            taken |= 1 << i;
+            res = i;
+            break; }
+    if (lock) asm volatile("out res[%0],%0"::"r"(lock):"memory");
+    return res;
+}
+
+void taskGraph::loop() {
+    while (done != all) {
+        int i = pick();
+        if (i < 0) { XCSchedulerYield(); continue; }     //returns immediately if no scheduler
+        graphNode & n = nodes[ i ];
+        n.start = XC::getTime() - t0;
+        n.fn(n.arg);
+        n.end = XC::getTime() - t0;
+        if (lock) asm volatile("in %0,res[%0]"::"r"(lock):"memory");
+        done |= 1 << i;
+        if (lock) asm volatile("out res[%0],%0"::"r"(lock):"memory");
+    }
+}
+
+void taskGraph::launch() {
+    taken = done = 0;
+    if (lock == 0) lock = XC::getRessource(XC::TYPE_LOCK);
+    if (lock == 0) __builtin_trap();
+    t0 = XC::getTime();
+}
+
+//compute the longest path ending at each step, steps being in topological order
+void taskGraph::finish() {
+    for (unsigned i = 0; i < count; i++) {
+        int longest = 0;
+        for (unsigned d = 0; d < i; d++)
+            if ((nodes[ i ].deps & (1 << d)) && (nodes[ d ].path > longest)) longest = nodes[ d ].path;
+        nodes[ i ].path = longest + nodes[ i ].end - nodes[ i ].start;
+    }
+    XC::freerr(lock);
+    lock = 0;
+}
+
+//scheduler task entry point, param is the graph
+extern "C" void XCtaskGraphTask(unsigned graph) {
+    ((taskGraph *)graph)->loop();
+}
+
+void taskGraph::runTasks(const unsigned n, const unsigned stackWords) {
+    launch();
+    //stack size cannot be computed from .nstackwords as steps are called indirectly
+    for (unsigned i = 0; i < n; i++)
+        XCSchedulerCreateTask_(XC_ADDRESS(XCtaskGraphTask), stackWords, (unsigned)"taskGraph", (unsigned)this);
+    loop();
+    finish();
+}
+
+int taskGraph::makespan() const {
+    int last = 0;
+    for (unsigned i = 0; i < count; i++) if (nodes[ i ].end > last) last = nodes[ i ].end;
+    return last;
+}
+
+int taskGraph::criticalLast() const {
+    int last = -1;
+    for (unsigned i = 0; i < count; i++) if ((last < 0) || (nodes[ i ].path > nodes[ last ].path)) last = i;
+    return last;
+}
+
+int taskGraph::criticalPath() const {
+    int last = criticalLast();
+    return (last < 0) ? 0 : nodes[ last ].path;
+}
+
+int taskGraph::criticalPrevious(const int i) const {
+    int prev = -1;
+    for (int d = 0; d < i; d++)
+        if ((nodes[ i ].deps & (1 << d)) && ((prev < 0) || (nodes[ d ].path > nodes[ prev ].path))) prev = d;
+    return prev;
+}
+
+};  //namespace XC
@@ -0,0 +1,98 @@
+#include <xs1.h>
+#include "XC_timerwheel.hpp"
+
+XCTimerWheel::XCTimerWheel(const unsigned tt) : current(0), count(0) {
+    for (unsigned i = 0; i < SIZE0; i++) tv1[ i ].next = tv1[ i ].prev = &tv1[ i ];
+    for (unsigned i = 0; i < SIZE1; i++) {
+        tv2[ i ].next = tv2[ i ].prev = &tv2[ i ];
+        tv3[ i ].next = tv3[ i ].prev = &tv3[ i ]; }
+    tickTicks = tt ? tt : XC::getReferenceHz() / 1000;
+    nextTime = XC::getTime() + tickTicks;
+}
+
+void XCTimerWheel::unlink(XCWheelNode * n) {
+    n->prev->next = n->next;
+    n->next->prev = n->prev;
+    n->next = n->prev = nullptr;
+}
+
+//put the timer in the slot of the level covering its remaining delay
+void XCTimerWheel::insert(XCWheelTimer * t) {
+    int delta = t->expires - current;
+    XCWheelNode * head;
+    if (delta < 0) head = &tv1[ current & (SIZE0-1) ];      //already due, processed at this tick
+    else if (delta < (int)SIZE0) head = &tv1[ t->expires & (SIZE0-1) ];
+    else if (delta < (int)(SIZE0 << BITS1)) head = &tv2[ (t->expires >> BITS0) & (SIZE1-1) ];
+    else if (delta < (int)(SIZE0 << (2*BITS1))) head = &tv3[ (t->expires >> (BITS0+BITS1)) & (SIZE1-1) ];
+    else head = &tv3[ ((current + (SIZE0 << (2*BITS1)) - 1) >> (BITS0+BITS1)) & (SIZE1-1) ];  //re-cascaded later
+    t->next = head;
+    t->prev = head->prev;
+    head->prev->next = t;
+    head->prev = t;
+}
+
+//move all timers of a slot to lower levels. return the index, 0 meaning upper level must cascade too
+unsigned XCTimerWheel::cascade(XCWheelNode * tv, const unsigned index) {
+    XCWheelNode * head = &tv[ index ];
+    XCWheelNode * n = head->next;
+    head->next = head->prev = head;
+    while (n != head) {
+        XCWheelNode * next = n->next;
+        insert((XCWheelTimer *)n);
+        n = next; }
+    return index;
+}
+
+//process one tick : cascade when level 0 wraps, then fire the timers of the current slot
+unsigned XCTimerWheel::tick() {
+    unsigned fired = 0;
+    unsigned index = current & (SIZE0-1);
+    if (index == 0)
+        if (cascade(tv2, (current >> BITS0) & (SIZE1-1)) == 0)
+            cascade(tv3, (current >> (BITS0+BITS1)) & (SIZE1-1));
+    XCWheelNode * head = &tv1[ index ];
+    //detach the list, so callbacks can start or cancel any timer
+    XCWheelNode list;
+    if (head->next != head) {
+        list.next = head->next; list.prev = head->prev;
+        list.next->prev = &list; list.prev->next = &list;
+        head->next = head->prev = head;
+        while (list.next != &list) {
+            XCWheelTimer * t = (XCWheelTimer *)list.next;
+            unlink(t);
+            if (t->period) { t->expires += t->period; insert(t); }
+            else count--;
+            fired++;
+            t->fn(t->arg);
+        }
+    }
+    current++;
+    return fired;
+}
+
+void XCTimerWheel::start(XCWheelTimer & t, const unsigned ticks, XC::voidFuncVoid_t * fn, void * arg, const bool periodic) {
+    if (t.active()) unlink(&t); else count++;
+    t.fn = fn;
+    t.arg = arg;
+    t.period = periodic ? ticks : 0;
+    t.expires = current + (ticks ? ticks : 1);
+    insert(&t);
+}
+
+void XCTimerWheel::cancel(XCWheelTimer & t) {
+    if (t.active()) { unlink(&t); count--; }
+}
+
+unsigned XCTimerWheel::poll() {
+    unsigned fired = 0;
+    while ((int)(XC::getTime() - nextTime) >= 0) {
+        fired += tick();
+        nextTime += tickTicks; }
+    return fired;
+}
+
+void XCTimerWheel::run() {
+    while (1) {
+        XCSchedulerYieldUntil(nextTime);    //single timer event per tick for the whole wheel
+        poll(); }
+}
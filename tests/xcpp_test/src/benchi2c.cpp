@@ -0,0 +1,174 @@
+
+
+#include <xs1.h>
+#include <platform.h>
+#include "debug_print.h"
+void debug_printf(char const fmt[], ...) asm("debug_printf");
+#include "XC_scheduler.h"
+#include "XC_core.hpp"
+#include "XC_I2C_clocked.hpp"
+#include "XC_I2C_queue.hpp"
+
+//clocked I2C master against a slave model running on another thread, master pins wired to the slave ones :
+//xsim --plugin LoopbackPort.dll '-port tile[0] XS1_PORT_1H 1 0 -port tile[0] XS1_PORT_1J 1 0
+//  -port tile[0] XS1_PORT_1I 1 0 -port tile[0] XS1_PORT_1K 1 0' bin/xcpp_test.xe
+
+static XCPort  benchScl(XS1_PORT_1H), benchSda(XS1_PORT_1I);
+static XCPort  benchSlaveScl(XS1_PORT_1J), benchSlaveSda(XS1_PORT_1K);
+static XCClock benchI2CClock(XC::CLKBLK_3);
+
+//slave model : 256 registers with auto increment, holds scl low during 2us after each acknowledge
+#define BENCH_I2C_DEVICE 0x3C
+static unsigned char benchI2CRegs[ 256 ];
+static volatile bool benchI2CStop;
+enum { I2C_MODEL_START = -1, I2C_MODEL_STOP = -2 };
+
+//one bit sampled on scl rising edge. sda changing while scl is high is a start or a stop
+static int benchI2CBit() {
+    benchSlaveScl.waitEqual(1);
+    const unsigned b = benchSlaveSda.peek() & 1;
+    while (benchSlaveScl.peek() & 1) {
+        const unsigned s = benchSlaveSda.peek() & 1;
+        if (s != b) return s ? I2C_MODEL_STOP : I2C_MODEL_START;
+    }
+    return b;
+}
+
+static int benchI2CByte() {
+    int v = 0;
+    for (unsigned i = 0; i < 8; i++) {
+        const int b = benchI2CBit();
+        if (b < 0) return b;
+        v = (v << 1) | b;
+    }
+    return v;
+}
+
+//acknowledge clock, then clock stretching while sda takes its next value (released, or first bit to send)
+static void benchI2CAck(const unsigned sdaNext) {
+    benchSlaveSda.clr();
+    benchSlaveScl.waitEqual(1);
+    benchSlaveScl.waitEqual(0);
+    benchSlaveScl.clr();
+    benchSlaveSda.set(sdaNext);
+    XC::delayTicks(200);
+    benchSlaveScl.set();
+}
+
+//8 bits driven while scl is low, return true when the master acknowledges
+static bool benchI2CSend(unsigned v) {
+    for (unsigned i = 0; i < 8; i++, v <<= 1) {
+        benchSlaveSda.set((v >> 7) & 1);
+        benchSlaveScl.waitEqual(1);
+        benchSlaveScl.waitEqual(0);
+    }
+    benchSlaveSda.set();
+    benchSlaveScl.waitEqual(1);
+    const bool ack = (benchSlaveSda.peek() & 1) == 0;
+    benchSlaveScl.waitEqual(0);
+    return ack;
+}
+
+static void benchI2CSlave(void * p) {
+    benchSlaveScl.setMode(XC::OUTPUT_PULLUP, 1);
+    benchSlaveSda.setMode(XC::OUTPUT_PULLUP, 1);
+    unsigned reg = 0;
+    int b = 0;
+    while (benchI2CStop == false) {
+        //wait a start : sda falls while scl is high
+        if (b != I2C_MODEL_START) {
+            benchSlaveSda.waitEqual(0);
+            if ((benchSlaveScl.peek() & 1) == 0) { benchSlaveSda.waitEqual(1); continue; }
+        }
+        benchSlaveScl.waitEqual(0);
+        b = benchI2CByte();
+        if (b < 0) continue;
+        if ((b >> 1) != BENCH_I2C_DEVICE) { b = 0; continue; }
+        if (b & 1) {
+            benchI2CAck(benchI2CRegs[ reg & 255 ] >> 7);
+            while (benchI2CSend(benchI2CRegs[ reg & 255 ])) reg++;
+            reg++;
+            b = 0;
+        } else {
+            benchI2CAck(1);
+            bool first = true;
+            while ((b = benchI2CByte()) >= 0) {
+                if (first) reg = b; else benchI2CRegs[ reg++ & 255 ] = b;
+                first = false;
+                benchI2CAck(1);
+            }
+        }
+    }
+}
+
+//register writes and reads at 1000kbit/s, a missing device must NACK, clock stretching must be seen
+void benchI2CClocked() {
+    static XC::threadPool<1, 256> pool;
+    XCI2CClocked i2c(benchScl, benchSda, benchI2CClock);
+    benchI2CStop = false;
+    pool.submit(0, benchI2CSlave);
+    pool.fork();
+    i2c.masterInit(1000);
+    char tx[ 32 ], rx[ 32 ];
+    for (unsigned i = 0; i < sizeof(tx); i++) tx[ i ] = i * 37 + 5;
+    unsigned errors = 0, sent;
+    if (i2c.testDevice(BENCH_I2C_DEVICE + 1) != NACK) errors++;
+    if (i2c.testDevice(BENCH_I2C_DEVICE) != ACK) errors++;
+    int time = XCS_GET_TIME();
+    if (i2c.writeRegs(BENCH_I2C_DEVICE, 0x10, sizeof(tx), tx, sent) != ACK) errors++;
+    time = XCS_GET_TIME() - time;
+    int timeRead = XCS_GET_TIME();
+    if (i2c.readRegs(BENCH_I2C_DEVICE, 0x10, sizeof(rx), rx) != ACK) errors++;
+    timeRead = XCS_GET_TIME() - timeRead;
+    for (unsigned i = 0; i < sizeof(tx); i++) if (rx[ i ] != tx[ i ]) errors++;
+    unsigned val = 0;
+    if ((i2c.writeReg(BENCH_I2C_DEVICE, 0x80, 0xA5) != ACK) || (i2c.readReg(BENCH_I2C_DEVICE, 0x80, val) != ACK) || ((val & 255) != 0xA5)) errors++;
+    //34 bytes on the bus for 32 registers, 100 ticks per us
+    debug_printf("i2c clocked : %d errors, %d stretched, write 32 regs %dus, read 32 regs %dus\n",
+        errors, i2c.stretched, time / 100, timeRead / 100);
+    benchI2CStop = true;
+    i2c.testDevice(BENCH_I2C_DEVICE);   //one more transaction to leave the slave loop
+    pool.join();
+    pool.stop();
+    i2c.stop();
+}
+
+//8 single register writes and one read of the 8 registers submitted at once, executed by an engine thread
+static XCI2CTransaction benchI2CWrites[ 8 ], benchI2CRead;
+static volatile unsigned benchI2CCallbacks;
+static void benchI2CDone(void * p) { benchI2CCallbacks++; }
+static void benchI2CEngine(void * q) { ((XCI2CQueue<XCI2CClocked> *)q)->run(); }
+
+void benchI2CQueue() {
+    static XC::threadPool<2, 256> pool;
+    XCI2CClocked i2c(benchScl, benchSda, benchI2CClock);
+    XCI2CQueue<XCI2CClocked> queue(i2c);
+    benchI2CStop = false;
+    benchI2CCallbacks = 0;
+    i2c.masterInit(1000);
+    pool.submit(0, benchI2CSlave);
+    pool.submit(1, benchI2CEngine, &queue);
+    pool.fork();
+    char rx[ 8 ];
+    int time = XCS_GET_TIME();
+    for (unsigned i = 0; i < 8; i++) {
+        benchI2CWrites[ i ].setWrite(BENCH_I2C_DEVICE, 0x20 + i, nullptr, 1).data[ 0 ] = i * 29 + 3;
+        benchI2CWrites[ i ].fn = benchI2CDone;
+        queue.submit(benchI2CWrites[ i ]);
+    }
+    benchI2CRead.setRead(BENCH_I2C_DEVICE, 0x20, rx, 8).fn = benchI2CDone;
+    queue.submit(benchI2CRead);
+    time = XCS_GET_TIME() - time;
+    while (benchI2CRead.done == false) XCSchedulerYield();
+    unsigned errors = (benchI2CCallbacks != 9) + queue.nacks;
+    for (unsigned i = 0; i < 8; i++) if ((unsigned char)rx[ i ] != (unsigned char)(i * 29 + 3)) errors++;
+    //100 ticks per us
+    debug_printf("i2c queue : %d errors, 9 submits in %d ticks, max depth %d, latency min %dus avg %dus max %dus, bus max %dus\n",
+        errors, time, queue.maxDepth, queue.latencyMin / 100, queue.latencyAverage() / 100, queue.latencyMax / 100, queue.busMax / 100);
+    queue.stop();
+    benchI2CStop = true;
+    i2c.testDevice(BENCH_I2C_DEVICE);   //engine stopped, one more transaction to leave the slave loop
+    pool.join();
+    pool.stop();
+    i2c.stop();
+}
@@ -0,0 +1,174 @@
+
+
+#include <xs1.h>
+#include <platform.h>
+#include "debug_print.h"
+void debug_printf(char const fmt[], ...) asm("debug_printf");
+#include "XC_scheduler.h"
+#include "XC_core.hpp"
+
+//benchmarks for parallel jobs on hardware threads, to be launched from a tile task under xsim
+
+static volatile unsigned benchJobCount;
+
+extern "C" void benchEmptyJob(unsigned n) { benchJobCount++; }
+static void benchEmptyPoolJob(void * p) { benchJobCount++; }
+
+//fork/join latency of 3 empty jobs : XC::jobs (getr, getst, init, malloc, mjoin, freer) against XC::threadPool
+void benchForkJoin() {
+    const int loops = 100;
+    benchJobCount = 0;
+    int time = XCS_GET_TIME();
+    for (int i=0; i<loops; i++) {
+        XC::jobs JOBS;
+        XC::onejob t1( benchEmptyJob, XC_NSTACKWORDS(benchEmptyJob), 1 );
+        XC::onejob t2( benchEmptyJob, XC_NSTACKWORDS(benchEmptyJob), 2 );
+        XC::onejob t3( benchEmptyJob, XC_NSTACKWORDS(benchEmptyJob), 3 );
+        JOBS( t1, t2, t3 );
+    }
+    time = XCS_GET_TIME() - time;
+    debug_printf("XC::jobs       : %d ticks per fork/join (%d jobs)\n", time / loops, benchJobCount);
+
+    static XC::threadPool<3, 64> pool;
+    pool.start();
+    benchJobCount = 0;
+    time = XCS_GET_TIME();
+    for (int i=0; i<loops; i++) {
+        for (int n=0; n<3; n++) pool.submit(n, benchEmptyPoolJob);
+        pool.fork();
+        pool.join();
+    }
+    time = XCS_GET_TIME() - time;
+    debug_printf("XC::threadPool : %d ticks per fork/join (%d jobs)\n", time / loops, benchJobCount);
+    pool.stop();
+}
+
+//each job burns a different time then writes its frame number : after join every slot must hold the
+//current frame, including the very first fork of the pool
+static volatile int benchJoinDone[ 3 ];
+static volatile int benchJoinFrame;
+static void benchJoinJob(void * p) {
+    const int n = (int)p;
+    int time = XCS_SET_TIME(1000 * (n + 1));
+    while (XCS_ONGOING_TIME(time)) { }
+    benchJoinDone[ n ] = benchJoinFrame;
+}
+
+void testThreadPoolJoin() {
+    static XC::threadPool<3, 64> pool;
+    unsigned errors = 0;
+    for (int frame = 1; frame <= 10; frame++) {
+        benchJoinFrame = frame;
+        for (int n=0; n<3; n++) pool.submit<benchJoinJob>(n, (void *)n);
+        pool.fork();
+        pool.join();
+        for (int n=0; n<3; n++) if (benchJoinDone[ n ] != frame) errors++;
+    }
+    debug_printf("threadPool join : %d errors\n", errors);
+    pool.stop();
+}
+
+static int benchSamples[ 4096 ];
+static int benchBank[ 16 ][ 64 ];
+
+//one channel of a filter bank : 64 taps over 256 samples
+static void benchFilter(int ch) {
+    long long acc = 0;
+    for (int i=0; i<256; i++)
+        for (int t=0; t<64; t++) acc += (long long)benchSamples[ i + t ] * benchBank[ ch ][ t ];
+    benchBank[ ch ][ 0 ] = acc >> 32;
+}
+
+//16 channels filter bank on 1 thread and on 7 threads, then a sum of squares reduction.
+//6 workers plus the caller, the threads left by tile0_task1 and tile0_task2
+void benchParallel() {
+    static XC::threadPool<6, 200> pool;
+    for (int i=0; i<4096; i++) benchSamples[ i ] = i * 12345;
+    int time = XCS_GET_TIME();
+    for (int ch=0; ch<16; ch++) benchFilter(ch);
+    time = XCS_GET_TIME() - time;
+    debug_printf("filter bank sequential     : %d ticks\n", time);
+    time = XCS_GET_TIME();
+    XC::parallelFor(pool, 0, 16, 2, [](int from, int to) { for (int ch = from; ch < to; ch++) benchFilter(ch); });
+    time = XCS_GET_TIME() - time;
+    debug_printf("filter bank parallelFor    : %d ticks\n", time);
+    time = XCS_GET_TIME();
+    XC::parallelFor(pool, 0, 16, 1, [](int from, int to) { for (int ch = from; ch < to; ch++) benchFilter(ch); }, XC::CHUNK_DYNAMIC);
+    time = XCS_GET_TIME() - time;
+    debug_printf("filter bank dynamic        : %d ticks\n", time);
+    time = XCS_GET_TIME();
+    long long energy = XC::parallelReduce(pool, 0, 4096, 256, 0LL,
+        [](int from, int to) { long long e = 0; for (int i = from; i < to; i++) e += (long long)benchSamples[ i ] * benchSamples[ i ]; return e; },
+        [](long long a, long long b) { return a + b; });
+    time = XCS_GET_TIME() - time;
+    debug_printf("parallelReduce energy %d in %d ticks\n", (int)(energy >> 32), time);
+    pool.stop();
+}
+
+//task burning the number of ticks given as parameter
+static void benchBurn(void * p) {
+    int time = XCS_SET_TIME((int)p);
+    while (XCS_ONGOING_TIME(time)) { }
+}
+
+//64 tasks where one channel out of 7 is 10 times longer, distributed round robin on 7 workers
+//(6 threads plus the caller). utilisation is busy time / (7 x elapsed time), without then with stealing
+void benchWorkStealing() {
+    static XC::workStealing<6, 100, 64> ws;
+    for (int steal = 0; steal <= 1; steal++) {
+        ws.clear();
+        for (int i=0; i<64; i++) ws.push(i % 7, benchBurn, (void *)(((i % 7) == 0) ? 10000 : 1000));
+        int time = XCS_GET_TIME();
+        ws.run(steal);
+        time = XCS_GET_TIME() - time;
+        debug_printf("work stealing %d : %d ticks, utilisation %d%%\n", steal, time, (ws.busy() * 100) / (7 * time));
+    }
+    ws.stop();
+}
+
+static void benchTypedJob(int * counter, int value) { *counter += value; }
+
+struct benchObject {
+    int total;
+    void add(int v) { total += v; }
+};
+
+//launch cost of 3 jobs with typed arguments, a member function and a lambda, without heap
+void benchJobGroup() {
+    const int loops = 100;
+    static int a, b;
+    static benchObject obj;
+    benchObject * pobj = &obj;
+    int time = XCS_GET_TIME();
+    for (int i=0; i<loops; i++) {
+        XC::jobGroup g;
+        XC_JOB_FUNC(g, benchTypedJob, &a, i);
+        XC_JOB(g, pobj->add, 2);
+        XC_JOB_LAMBDA(g, [&]{ b++; });
+    }
+    time = XCS_GET_TIME() - time;
+    debug_printf("XC::jobGroup   : %d ticks per fork/join, a %d obj %d b %d\n", time / loops, a, obj.total, b);
+}
+
+#include "XC_taskgraph.hpp"
+
+//boot sequence : pll -> stabilize -> i2c -> codec -> i2s, with dsp init and buffers in parallel
+static XC::graphNode benchBoot[] = {
+    /* 0 */ { "pll",       benchBurn, (void *)1000,  XC::deps() },
+    /* 1 */ { "stabilize", benchBurn, (void *)50000, XC::deps(0) },
+    /* 2 */ { "dsp",       benchBurn, (void *)30000, XC::deps() },
+    /* 3 */ { "buffers",   benchBurn, (void *)20000, XC::deps() },
+    /* 4 */ { "i2c",       benchBurn, (void *)5000,  XC::deps(1) },
+    /* 5 */ { "codec",     benchBurn, (void *)20000, XC::deps(4) },
+    /* 6 */ { "i2s",       benchBurn, (void *)1000,  XC::deps(2,3,5) },
+};
+
+void benchTaskGraph() {
+    static XC::threadPool<2, 100> pool;
+    XC::taskGraph graph(benchBoot, 7);
+    graph.run(pool);
+    debug_printf("task graph : makespan %d ticks, critical path %d ticks :", graph.makespan(), graph.criticalPath());
+    for (int i = graph.criticalLast(); i >= 0; i = graph.criticalPrevious(i)) debug_printf(" %s", benchBoot[ i ].name);
+    debug_printf("\n");
+    pool.stop();
+}
@@ -0,0 +1,247 @@
+
+
+#include <xs1.h>
+#include <platform.h>
+#include "debug_print.h"
+void debug_printf(char const fmt[], ...) asm("debug_printf");
+#include "XC_scheduler.h"
+#include "XC_core.hpp"
+#include "XC_stackpool.h"
+
+//benchmarks for the cooperative scheduler, to be launched from a tile task under xsim
+
+static volatile unsigned benchSleepWakeups;
+
+//each task sleeps with its own period (1ms..10ms) and count its wake-ups
+extern "C" void benchSleepTask(int n) {
+    for (int i=0; i<100; i++) {
+        XCSchedulerYieldDelay(100000 * (n+1));
+        benchSleepWakeups++;
+    }
+}
+
+//10 sleeping tasks during 1 second : cycles not spent blocked on the thread timer are wasted by the scheduler
+void benchSleepQueue() {
+    benchSleepWakeups = 0;
+    for (int n=0; n<10; n++) XCSchedulerCreateTaskParam(benchSleepTask,n);
+    unsigned idle = XCSchedulerIdleTicks();
+    int time = XCS_GET_TIME();
+    XCSchedulerYieldDelay(XC::getReferenceHz());
+    time = XCS_GET_TIME() - time;
+    idle = XCSchedulerIdleTicks() - idle;
+    debug_printf("sleep queue: %d wakeups, %d ticks elapsed, %d ticks wasted per second\n",
+        benchSleepWakeups, time, time - idle);
+    //wait for the longest task (10ms x 100) and stop scheduler
+    while (XCSchedulerYieldDelay(XC::getReferenceHz()/10)) { }
+}
+
+static volatile int benchLatencyMax;
+static volatile unsigned benchLatencyRun;
+
+//background task consuming about 20us between each yield
+extern "C" void benchBusyTask(int n) {
+    while (benchLatencyRun) {
+        int time = XCS_SET_TIME(2000);
+        while (XCS_ONGOING_TIME(time)) { }
+        XCSchedulerYield();
+    }
+}
+
+//wakes up every 100us and records the worst delay between its due time and its real execution
+extern "C" void benchLatencyTask(int n) {
+    int max = 0;
+    for (int i=0; i<1000; i++) {
+        XCStaskPtr_t me = XCSchedulerYieldDelay(10000);
+        int late = XCS_GET_TIME() - me->timeAfter;
+        if (late > max) max = late;
+    }
+    benchLatencyMax = max;
+    benchLatencyRun = 0;
+}
+
+//worst case scheduling latency of a task, with 8 busy tasks, in normal then in critical level
+void benchPriorityLatency() {
+    for (int prio = XCS_PRIORITY_NORMAL; prio <= XCS_PRIORITY_CRITICAL; prio += XCS_PRIORITY_CRITICAL-XCS_PRIORITY_NORMAL) {
+        benchLatencyRun = 1;
+        for (int n=0; n<8; n++) XCSchedulerCreateTaskParam(benchBusyTask,n);
+        XCSchedulerCreateTaskPriority(benchLatencyTask,0,prio);
+        while (XCSchedulerYield()) { }
+        debug_printf("priority %d: worst latency %d ticks\n", prio, benchLatencyMax);
+    }
+}
+
+//short lived task, ends after one yield
+extern "C" void benchShortTask(int n) {
+    XCSchedulerYield();
+}
+
+//create and destroy 1000 short lived tasks, and compare the cost of a pool block against malloc/free
+void benchStackPool() {
+    for (int i=0; i<1000; i++) {
+        for (int n=0; n<4; n++) XCSchedulerCreateTaskParam(benchShortTask,n);
+        while (XCSchedulerYield()) { }
+    }
+    int time = XCS_GET_TIME();
+    void * p = XCStackPoolAlloc(&XCStackPool, 256);
+    XCStackPoolFree(&XCStackPool, p);
+    time = XCS_GET_TIME() - time;
+    int timeHeap = XCS_GET_TIME();
+    p = malloc(256);
+    free(p);
+    timeHeap = XCS_GET_TIME() - timeHeap;
+    debug_printf("stack pool: high water %d/%d blocks, %d fallbacks, alloc+free %d ticks (malloc+free %d)\n",
+        XCStackPoolHighWater(&XCStackPool), XC_STACKPOOL_BLOCKS, XCStackPool.fallbacks, time, timeHeap);
+}
+
+static volatile unsigned benchYieldRun;
+static XCStaskPtr_t benchYieldTcb;
+
+extern "C" void benchYieldTask(int n) {
+    while (benchYieldRun) benchYieldTcb = XCSchedulerYield();
+}
+
+//cost of a yield between two tasks, and part of it spent checking the stack guard
+void benchStackCheck() {
+    benchYieldRun = 1;
+    XCSchedulerCreateTaskParam(benchYieldTask,0);
+    XCSchedulerYield();
+    int time = XCS_GET_TIME();
+    for (int i=0; i<1000; i++) XCSchedulerYield();
+    time = XCS_GET_TIME() - time;
+    int check = XCS_GET_TIME();
+    for (int i=0; i<1000; i++) XCSchedulerStackCheck(benchYieldTcb);
+    check = XCS_GET_TIME() - check;
+    benchYieldRun = 0;
+    while (XCSchedulerYield()) { }
+    //one yield from main is 2 context switches. build with XC_SCHEDULER_STACK_CHECK=0 to compare
+    debug_printf("stack check: %d ticks per 1000 yield round trips, check %d ticks per 1000 calls\n", time, check);
+}
+
+//peak stack words used by a task compared to its .nstackwords
+extern "C" void benchStackTask(int n) {
+    XCStaskPtr_t me = XCSchedulerYield();
+    debug_printf("task stack peak %d words, nstackwords %d\n", XCSchedulerStackPeak(me), XC_NSTACKWORDS(benchStackTask));
+}
+
+void benchStackPeak() {
+    XCSchedulerCreateTask(benchStackTask);
+    while (XCSchedulerYield()) { }
+}
+
+#if defined(XC_SCHEDULER_STATS) && (XC_SCHEDULER_STATS == 1)
+//run the sleeping tasks and busy tasks together, then print per task counters and latency histogram
+void benchSchedulerStats() {
+    XCSchedulerStatsReset();
+    benchLatencyRun = 1;
+    for (int n=0; n<4; n++) XCSchedulerCreateTaskParam(benchBusyTask,n);
+    XCSchedulerCreateTaskPriority(benchLatencyTask,0,XCS_PRIORITY_HIGH);
+    XCSchedulerYieldDelay(XC::getReferenceHz()/100);
+    XCSchedulerStatsPrint();
+    while (XCSchedulerYield()) { }
+}
+#endif
+
+#include "XC_coroutine.hpp"
+
+//lightweight state machine toggling a counter every period
+class benchBlink : public XCCoroutine {
+    int period; unsigned i;
+public:
+    volatile unsigned count;
+    benchBlink(int p) : period(p), count(0) { }
+    bool step() {
+        XC_CO_BEGIN();
+        for (i = 0; i < 100; i++) {
+            count++;
+            XC_CO_AWAIT_DELAY(period);
+        }
+        XC_CO_END();
+    }
+};
+
+//32 coroutines sharing one task stack, compared to 32 scheduler tasks each with its own stack
+void benchCoroutines() {
+    static XCCoroutineArena<benchBlink, 32> arena;
+    static XCCoroutineRunner runner;
+    for (int n=0; n<32; n++) runner.add(arena.create(10000 * (n+1)));
+    unsigned idle = XCSchedulerIdleTicks();
+    int time = XCS_GET_TIME();
+    runner.start();
+    while (XCSchedulerYield()) { }
+    time = XCS_GET_TIME() - time;
+    idle = XCSchedulerIdleTicks() - idle;
+    debug_printf("coroutines: 32 x 100 steps in %d ticks, %d busy, %d left in arena, %d bytes per coroutine\n",
+        time, time - idle, arena.count(), sizeof(benchBlink));
+}
+
+#include "XC_sync.hpp"
+
+static XCSemaphore benchPing, benchPong;
+static XCMutex     benchMutex;
+static volatile unsigned benchShared;
+static XCEventFlags benchStop;
+
+extern "C" void benchNeverTask(int n) {
+    benchStop.waitAny(1 << n);
+}
+
+extern "C" void benchPingTask(int n) {
+    for (int i=0; i<1000; i++) {
+        benchPing.take();
+        { XCMutexGuard g(benchMutex); benchShared++; }
+        benchPong.give();
+    }
+}
+
+//ping-pong between main and a task through two semaphores : cost of one hand-over,
+//while 8 other tasks are blocked on an event, and consume nothing
+void benchSync() {
+    for (int n=0; n<8; n++) XCSchedulerCreateTaskParam(benchNeverTask,n);
+    XCSchedulerCreateTaskParam(benchPingTask,0);
+    int time = XCS_GET_TIME();
+    for (int i=0; i<1000; i++) {
+        benchPing.give();
+        benchPong.take();
+    }
+    time = XCS_GET_TIME() - time;
+    debug_printf("sync: %d ticks per ping-pong, shared %d\n", time / 1000, benchShared);
+    benchStop.set(0xFF);
+    while (XCSchedulerYield()) { }
+}
+
+#include "XC_governor.hpp"
+
+//scripted load in percent of each 1ms window, one phase per 100ms
+static const unsigned benchLoadScript[] = { 10, 95, 95, 50, 20, 10, 90, 5 };
+static volatile unsigned benchLoad;
+static volatile unsigned benchLoadRun;
+
+extern "C" void benchLoadTask(int n) {
+    while (benchLoadRun) {
+        int time = XCS_SET_TIME(benchLoad * 1000);
+        while (XCS_ONGOING_TIME(time)) { }
+        XCSchedulerYieldDelay(100000 - benchLoad * 1000);
+    }
+}
+
+//governor in dry run, sampling every 10ms the idle time left by a task following the load script
+void benchGovernor() {
+    static const unsigned points[] = { 0, 1, 2 };   //not written in dry run
+    XCGovernor governor(points, 3);
+    governor.dryRun = true;
+    benchLoad = benchLoadScript[ 0 ];
+    benchLoadRun = 1;
+    XCSchedulerCreateTaskParam(benchLoadTask,0);
+    governor.update();
+    for (unsigned phase = 0; phase < sizeof(benchLoadScript)/sizeof(unsigned); phase++) {
+        benchLoad = benchLoadScript[ phase ];
+        for (int i=0; i<10; i++) {
+            XCSchedulerYieldDelay(1000000);
+            unsigned load = governor.update();
+            if (i == 9) debug_printf("script %d%% : measured %d%%, point %d\n", benchLoad, load, governor.point());
+        }
+    }
+    debug_printf("governor : %d transitions\n", governor.transitions);
+    benchLoadRun = 0;
+    while (XCSchedulerYield()) { }
+}
@@ -0,0 +1,219 @@
+
+
+#include <xs1.h>
+#include <platform.h>
+#include "debug_print.h"
+void debug_printf(char const fmt[], ...) asm("debug_printf");
+#include "XC_scheduler.h"
+#include "XC_core.hpp"
+#include "XC_SPI_master.hpp"
+#include "XC_SPI_base.hpp"
+
+//benchmarks and loopback tests for the SPI engines, to be launched from a tile task under xsim with mosi wired to miso :
+//xsim --plugin LoopbackPort.dll '-port tile[0] XS1_PORT_1B 1 0 -port tile[0] XS1_PORT_1C 1 0' bin/xcpp_test.xe
+
+//a loopback bench with errors stops the test application, so xsim reports the failure
+static void benchSpiCheck(const char * name, const unsigned errors) {
+    if (errors == 0) return;
+    debug_printf("%s FAILED\n", name);
+    __builtin_trap();
+}
+
+static XCPort  benchSclk(XS1_PORT_1A), benchMosi(XS1_PORT_1B), benchMiso(XS1_PORT_1C);
+static XCClock benchSpiClock(XC::CLKBLK_1);
+
+//every mode and size must return what was sent, then 1000 transfers of 32 bits at divide 1
+void benchSpiLoopback() {
+    XCSpiMaster spi(benchSclk, benchMosi, benchMiso, benchSpiClock);
+    unsigned errors = 0;
+    for (unsigned mode = 0; mode < 4; mode++) {
+        spi.init(mode, 1);
+        for (unsigned size = 1; size <= 32; size++) {
+            unsigned val = (0xA5C3F00F ^ (size * 0x01010101)) & (0xFFFFFFFF >> (32-size));
+            if (spi.transfer(val, size) != val) errors++;
+        }
+    }
+    int time = XCS_GET_TIME();
+    for (int i=0; i<1000; i++) if (spi.transfer(i, 32) != (unsigned)i) errors++;
+    time = XCS_GET_TIME() - time;
+    //32000 bits, 100 ticks per us
+    debug_printf("spi loopback : %d errors, %d kbit/s with 32 bits transfers\n", errors, 3200000 / (time / 1000));
+    spi.stop();
+    benchSpiCheck("spi loopback", errors);
+}
+
+static unsigned char benchSpiTx[ 4096 ], benchSpiRx[ 4096 ];
+static unsigned char benchSpiA[ 512 ], benchSpiB[ 512 ];
+static XCPort benchSpiCsPort(XS1_PORT_1D);
+static XCPortBit benchSpiCs(benchSpiCsPort);
+
+//producer thread : 4KB posted in 512 bytes buffers
+static void benchSpiProducer(void * p) {
+    XCSpiStream & stream = *(XCSpiStream *)p;
+    for (unsigned done = 0; done < sizeof(benchSpiTx); ) {
+        unsigned char * b = stream.acquire();
+        for (unsigned i = 0; i < stream.capacity(); i++) b[ i ] = benchSpiTx[ done + i ];
+        stream.post(stream.capacity());
+        done += stream.capacity(); }
+    stream.post(0);
+}
+
+//consumer of the stream : each block received must match the bytes sent at the same offset
+static unsigned benchStreamDone, benchStreamErrors;
+static void benchSpiConsumer(void * arg, const unsigned char * rx, const unsigned n) {
+    for (unsigned i = 0; i < n; i++) if (rx[ i ] != benchSpiTx[ benchStreamDone + i ]) benchStreamErrors++;
+    benchStreamDone += n;
+}
+
+//4KB blocks in loopback : one transferBlock, then streamed from another thread through 2 buffers of 512 bytes
+void benchSpiBlock() {
+    XCSpiMaster spi(benchSclk, benchMosi, benchMiso, benchSpiClock);
+    spi.init(0, 1);
+    benchSpiCsPort.setMode(XC::OUTPUT_DRIVE, 1);
+    spi.setChipSelect(benchSpiCs);
+    for (unsigned i = 0; i < sizeof(benchSpiTx); i++) benchSpiTx[ i ] = i * 7 + (i >> 8);
+    int time = XCS_GET_TIME();
+    spi.transferBlock(benchSpiTx, benchSpiRx, sizeof(benchSpiTx));
+    time = XCS_GET_TIME() - time;
+    unsigned errors = 0;
+    for (unsigned i = 0; i < sizeof(benchSpiTx); i++) if (benchSpiRx[ i ] != benchSpiTx[ i ]) errors++;
+    //32768 bits, 100 ticks per us
+    debug_printf("spi block 4KB : %d errors, %d kbit/s\n", errors, 3276800 / (time / 1000));
+
+    static XC::threadPool<1, 128> pool;
+    XCSpiStream stream(benchSpiA, benchSpiB, sizeof(benchSpiA));
+    pool.submit(0, benchSpiProducer, &stream);
+    time = XCS_GET_TIME();
+    benchStreamDone = benchStreamErrors = 0;
+    pool.fork();
+    stream.run(spi, benchSpiRx, benchSpiConsumer);
+    pool.join();
+    time = XCS_GET_TIME() - time;
+    if (benchStreamDone != sizeof(benchSpiTx)) benchStreamErrors++;
+    debug_printf("spi stream 4KB : %d errors, %d kbit/s\n", benchStreamErrors, 3276800 / (time / 1000));
+    pool.stop();
+    spi.stop();
+    benchSpiCheck("spi block", errors + benchStreamErrors);
+}
+
+//quad SPI on a 4 bits port, with a second 4 bits port wired to it for the loopback :
+//xsim --plugin LoopbackPort.dll '-port tile[0] XS1_PORT_4A 4 0 -port tile[0] XS1_PORT_4B 4 0' bin/xcpp_test.xe
+static XCPort benchSio(XS1_PORT_4A), benchSioLoop(XS1_PORT_4B);
+
+//data phase written in sdr and ddr on 1, 2 and 4 lanes must be captured unchanged, then 4KB quad reads
+void benchQSpi() {
+    XCQSpiMaster qspi(benchSclk, benchSio, benchSpiClock);
+    qspi.setLoopback(benchSioLoop);
+    qspi.setChipSelect(benchSpiCs);
+    benchSpiCsPort.setMode(XC::OUTPUT_DRIVE, 1);
+    qspi.init(0, 1);
+    for (unsigned i = 0; i < 256; i++) benchSpiTx[ i ] = i ^ 0x5A;
+    unsigned errors = 0;
+    for (unsigned lanes = 1; lanes <= 4; lanes <<= 1)
+        for (unsigned ddr = 0; ddr < 2; ddr++) {
+            XCQSpiMaster::command pageProgram = { 0x32, 1, 3, (unsigned char)lanes, 0, (unsigned char)lanes, ddr != 0 };
+            qspi.write(pageProgram, 0x123456, benchSpiTx, 256, benchSpiRx);
+            for (unsigned i = 0; i < 256; i++) if (benchSpiRx[ i ] != benchSpiTx[ i ]) errors++;
+        }
+    static const XCQSpiMaster::command fastReadQuad = { 0xEB, 1, 3, 4, 6, 4, false };
+    static const XCQSpiMaster::command fastReadQuadDtr = { 0xED, 1, 3, 4, 6, 4, true };
+    int time = XCS_GET_TIME();
+    qspi.read(fastReadQuad, 0, benchSpiRx, 4096);
+    time = XCS_GET_TIME() - time;
+    int timeDdr = XCS_GET_TIME();
+    qspi.read(fastReadQuadDtr, 0, benchSpiRx, 4096);
+    timeDdr = XCS_GET_TIME() - timeDdr;
+    //32768 bits, 100 ticks per us
+    debug_printf("qspi loopback : %d errors, read 4KB sdr %d kbit/s, ddr %d kbit/s\n",
+        errors, 3276800 / (time / 1000), 3276800 / (timeDdr / 1000));
+    qspi.stop();
+}
+
+#include "XC_SPI_slave.hpp"
+
+//slave ports wired to the master ones (1A-1E sclk, 1B-1F mosi, 1D-1G chip select) :
+//xsim --plugin LoopbackPort.dll '-port tile[0] XS1_PORT_1A 1 0 -port tile[0] XS1_PORT_1E 1 0
+//  -port tile[0] XS1_PORT_1B 1 0 -port tile[0] XS1_PORT_1F 1 0 -port tile[0] XS1_PORT_1D 1 0 -port tile[0] XS1_PORT_1G 1 0'
+static XCPort  benchSlaveSclk(XS1_PORT_1E), benchSlaveMosi(XS1_PORT_1F), benchSlaveCs(XS1_PORT_1G);
+static XCClock benchSlaveClock(XC::CLKBLK_2);
+static XC_ALIGNED(4) unsigned char benchSlaveRing[ 1024 ];
+static XCSpiSlave benchSlave(benchSlaveSclk, benchSlaveMosi, benchSlaveCs, benchSlaveClock, benchSlaveRing, sizeof(benchSlaveRing));
+static volatile unsigned benchSlaveErrors, benchSlaveDone;
+#define BENCH_SLAVE_FRAMES 64
+
+static void benchSlaveEngine(void * p) { benchSlave.run(); }
+
+//drains the ring by blocks of 256 bytes and checks the sequence sent by the master
+static void benchSlaveConsumer(void * p) {
+    unsigned char block[ 256 ];
+    unsigned errors = 0, expected = 0;
+    for (unsigned b = 0; b < BENCH_SLAVE_FRAMES * 512 / 256; b++) {
+        unsigned got = 0;
+        while ((got < 256) && !benchSlaveDone) got += benchSlave.read(block + got, 256 - got);
+        for (unsigned i = 0; i < got; i++, expected++) if (block[ i ] != benchSpiTx[ expected & 511 ]) errors++;
+        if (got < 256) break;
+    }
+    benchSlaveErrors = errors;
+}
+
+//master at maximum rate (divide 1) sending frames of 512 bytes, slave on a thread, consumer on another
+void benchSpiSlave() {
+    XCSpiMaster spi(benchSclk, benchMosi, benchMiso, benchSpiClock);
+    spi.init(0, 1);
+    benchSpiCsPort.setMode(XC::OUTPUT_DRIVE, 1);
+    spi.setChipSelect(benchSpiCs);
+    benchSlave.init(0);
+    for (unsigned i = 0; i < 512; i++) benchSpiTx[ i ] = i + (i >> 8);
+    benchSlaveDone = 0;
+    static XC::threadPool<2, 256> pool;
+    pool.submit(0, benchSlaveEngine);
+    pool.submit(1, benchSlaveConsumer);
+    pool.fork();
+    for (unsigned f = 0; f < BENCH_SLAVE_FRAMES; f++) {
+        spi.transferBlock(benchSpiTx, nullptr, 512);
+        XC::delayTicks(100);    //1us between frames
+    }
+    XC::delayTicks(100000);
+    benchSlaveDone = 1;
+    benchSlave.stop();
+    spi.transferBlock(benchSpiTx, nullptr, 1);  //one more frame to leave the engine loop
+    pool.join();
+    debug_printf("spi slave : %d frames, %d bytes received, %d dropped, %d errors\n",
+        benchSlave.frames, benchSlave.received, benchSlave.dropped, benchSlaveErrors);
+    pool.stop();
+    spi.stop();
+    //every byte sent must be received once, none dropped
+    benchSpiCheck("spi slave", benchSlave.dropped + benchSlaveErrors + (benchSlave.received != BENCH_SLAVE_FRAMES * 512));
+}
+
+//bit banged bus with 4 latches of 8 bits and one of 16 bits daisy chained, sharing one rck
+static XCPort benchLatchPorts(XS1_PORT_4C);
+static XCPortBit benchLatchClk(benchLatchPorts, 0), benchLatchMosi(benchLatchPorts, 1), benchLatchMiso(benchLatchPorts, 2), benchLatchRck(benchLatchPorts, 3);
+static XCSpi benchLatchSpi(benchLatchClk, benchLatchMosi, benchLatchMiso, 0, 20);
+//bit index as int : with the default unsigned, setBit(T, unsigned) would duplicate setBit(T, T)
+static XCSpiLatch<benchLatchSpi, benchLatchRck, 8, int> benchRelay[ 4 ];
+static XCSpiLatch<benchLatchSpi, benchLatchRck, 16, int> benchLeds;
+static XCSpiLatchChain<benchLatchSpi, benchLatchRck> benchChain;
+
+//100 periods where a single bit changes every 10 periods : each latch updated separately, then the chain
+void benchSpiLatchChain() {
+    benchLatchPorts.setMode(XC::OUTPUT_DRIVE, 0);
+    benchLatchSpi.init();
+    for (unsigned i = 0; i < 4; i++) benchChain.add(benchRelay[ i ]);
+    benchChain.add(benchLeds).init();
+    int time = XCS_GET_TIME();
+    for (unsigned p = 0; p < 100; p++) {
+        if ((p % 10) == 0) benchLeds.setBit(p / 10);
+        for (unsigned i = 0; i < 4; i++) benchRelay[ i ].update();
+        benchLeds.update();
+    }
+    time = XCS_GET_TIME() - time;
+    int timeChain = XCS_GET_TIME();
+    for (unsigned p = 0; p < 100; p++) {
+        if ((p % 10) == 0) benchLeds.clrBit(p / 10);
+        benchChain.update();
+    }
+    timeChain = XCS_GET_TIME() - timeChain;
+    debug_printf("spi latches : separate %d ticks, chain %d ticks, %d frames, %d skipped\n",
+        time, timeChain, benchChain.frames, benchChain.skipped);
+}
@@ -0,0 +1,108 @@
+
+
+#include <xs1.h>
+#include <platform.h>
+#include "debug_print.h"
+void debug_printf(char const fmt[], ...) asm("debug_printf");
+#include "XC_scheduler.h"
+#include "XC_core.hpp"
+#include "XC_timerwheel.hpp"
+
+//benchmarks for the 64 bits time functions and timer wheel, to be launched from a tile task under xsim
+
+static volatile XC::LongLong_t benchTimeLast;   //latest value returned to any thread, accessed with LDD/STD
+static unsigned benchTimeErrors[ 8 ];     //per logical core
+static unsigned benchTimeCalls[ 8 ];
+
+//each call must return at least the latest value published by any thread before the call
+static void benchTimeStress(void * p) {
+    unsigned calls = 0, errors = 0;
+    for (int i=0; i<10000; i++) {
+        long long before = XC::lddi((const void *)&benchTimeLast, 0).ll;
+        long long now = XC::getTime64();
+        if (now < before) errors++;
+        else XC::stdi(now, (const void *)&benchTimeLast, 0);
+        calls++;
+    }
+    benchTimeErrors[ XC::getid() ] = errors;
+    benchTimeCalls[ XC::getid() ] = calls;
+}
+
+//7 threads calling getTime64 concurrently (6 workers and the caller) : monotonicity errors and cost of one call
+void benchTime64() {
+    static XC::threadPool<6, 64> pool;
+    for (int n=0; n<6; n++) pool.submit(n, benchTimeStress);
+    pool.fork();
+    benchTimeStress(nullptr);
+    pool.join();
+    pool.stop();
+    unsigned errors = 0, calls = 0;
+    for (int n=0; n<8; n++) { errors += benchTimeErrors[ n ]; calls += benchTimeCalls[ n ]; }
+    int time = XCS_GET_TIME();
+    for (int i=0; i<1000; i++) XC::getTime64();
+    time = XCS_GET_TIME() - time;
+    //10ns per tick at 100MHz reference
+    debug_printf("getTime64 : %d calls, %d monotonic errors, %d ns per call\n", calls, errors, time / 100);
+}
+
+//idle 30 seconds without calling any time function : without keeper the 64 bits time is wrong by 2^32 ticks.
+//events are cleared every second on this thread, the keeper must not depend on them.
+//to be run on hardware, too long for xsim
+void benchTime64Keeper() {
+    XC::startTime64Keeper();
+    long long start = XC::micros();
+    for (int i=0; i<30; i++) { XC::delayTicks(XC::getReferenceHz()); XC::clre(); }
+    debug_printf("time keeper : %d ms elapsed for 30000\n", (int)((XC::micros() - start) / 1000));
+}
+
+//N periodic timers of 1..N ms during 100ms : passes over XCSWTimerMicros polling versus passes of XCTimerWheel::poll
+#define BENCH_WHEEL_TIMERS 500
+static XCSWTimerMicros benchPolled[ BENCH_WHEEL_TIMERS ];
+static XCWheelTimer benchWheeled[ BENCH_WHEEL_TIMERS ];
+static XCTimerWheel benchWheel;
+static unsigned benchWheelFired;
+static void benchWheelCallback(void * p) { benchWheelFired++; }
+
+void benchTimerWheel() {
+    for (int i=0; i<BENCH_WHEEL_TIMERS; i++) benchPolled[ i ].set((i+1)*1000);
+    unsigned passes = 0, fired = 0;
+    XCSWTimerMillis duration; duration.set(100);
+    while (duration.ongoing()) {
+        for (int i=0; i<BENCH_WHEEL_TIMERS; i++)
+            if (benchPolled[ i ].finishedRearmSync()) fired++;
+        passes++; }
+    debug_printf("polling %d timers : %d passes, %d ns per pass, %d fired\n",
+        BENCH_WHEEL_TIMERS, passes, 100000000 / passes, fired);
+
+    for (int i=0; i<BENCH_WHEEL_TIMERS; i++) benchWheel.start(benchWheeled[ i ], i+1, benchWheelCallback, nullptr, true);
+    passes = 0; benchWheelFired = 0;
+    duration.set(100);
+    while (duration.ongoing()) { benchWheel.poll(); passes++; }
+    debug_printf("timer wheel %d timers : %d passes, %d ns per pass, %d fired\n",
+        benchWheel.active(), passes, 100000000 / passes, benchWheelFired);
+    for (int i=0; i<BENCH_WHEEL_TIMERS; i++) benchWheel.cancel(benchWheeled[ i ]);
+}
+
+//cost of 1000 calls of the dynamic conversions (global factors, PLL may change) versus compile time ones
+void benchMicrosFixed() {
+    int time = XCS_GET_TIME();
+    for (int i=0; i<1000; i++) XC::getTime64();
+    int base = XCS_GET_TIME() - time;
+    time = XCS_GET_TIME();
+    for (int i=0; i<1000; i++) XC::micros();
+    int dynMicros = XCS_GET_TIME() - time;
+    time = XCS_GET_TIME();
+    for (int i=0; i<1000; i++) XC::microsFixed();
+    int fixMicros = XCS_GET_TIME() - time;
+    time = XCS_GET_TIME();
+    for (int i=0; i<1000; i++) XC::millis();
+    int dynMillis = XCS_GET_TIME() - time;
+    time = XCS_GET_TIME();
+    for (int i=0; i<1000; i++) XC::millisFixed();
+    int fixMillis = XCS_GET_TIME() - time;
+    //100MHz reference timer ticks (not core cycles) per 1000 calls, minus getTime64 itself,
+    //gives the conversion cost in 1/1000 of tick
+    debug_printf("getTime64 %d, micros %d / fixed %d, millis %d / fixed %d reference ticks per 1000 calls\n",
+        base, dynMicros, fixMicros, dynMillis, fixMillis);
+    debug_printf("fixed micros %d us, dynamic micros %d us\n", (int)XC::microsFixed(), (int)XC::micros());
+}
@@ -196,7 +196,87 @@ void testcmdline() {
 }
 
 
-extern "C" void tile0_task1() { testScheduler(); };
+//benchmarks of the library, each one prints its results with debug_printf. XCPP_TEST_BENCH 1 runs them
+//once before the led demo. a bench taking hardware threads releases them before returning : at most
+//6 are free beside tile0_task1 and tile0_task2
+//XCPP_TEST_LOOPBACK 1 adds the SPI and I2C ones which need the LoopbackPort plugin wiring given in their file
+//XCPP_TEST_HARDWARE 1 adds the ones too long for xsim
+#ifndef XCPP_TEST_BENCH
+#define XCPP_TEST_BENCH 0
+#endif
+#ifndef XCPP_TEST_LOOPBACK
+#define XCPP_TEST_LOOPBACK 0
+#endif
+#ifndef XCPP_TEST_HARDWARE
+#define XCPP_TEST_HARDWARE 0
+#endif
+
+void benchSleepQueue();
+void benchPriorityLatency();
+void benchStackPool();
+void benchStackCheck(); void benchStackPeak();
+#if defined(XC_SCHEDULER_STATS) && (XC_SCHEDULER_STATS == 1)
+void benchSchedulerStats();
+#endif
+void benchCoroutines();
+void benchSync();
+void testThreadPoolJoin(); void benchForkJoin();
+void benchParallel();
+void benchWorkStealing();
+void benchJobGroup();
+void benchTaskGraph();
+void benchTime64();
+void benchTime64Keeper();
+void benchTimerWheel();
+void benchMicrosFixed();
+void benchGovernor();
+void benchSpiLoopback();
+void benchSpiBlock();
+void benchQSpi();
+void benchSpiSlave();
+void benchSpiLatchChain();
+void benchI2CClocked();
+void benchI2CQueue();
+
+void runBenches() {
+    benchSleepQueue();
+    benchPriorityLatency();
+    benchStackPool();
+    benchStackCheck();
+    benchStackPeak();
+#if defined(XC_SCHEDULER_STATS) && (XC_SCHEDULER_STATS == 1)
+    benchSchedulerStats();
+#endif
+    benchCoroutines();
+    benchSync();
+    testThreadPoolJoin();
+    benchForkJoin();
+    benchParallel();
+    benchWorkStealing();
+    benchJobGroup();
+    benchTaskGraph();
+    benchTime64();
+    benchTimerWheel();
+    benchMicrosFixed();
+    benchGovernor();
+    //output only, 4C is not wired back
+    benchSpiLatchChain();
+#if XCPP_TEST_LOOPBACK
+    benchSpiLoopback();
+    benchSpiBlock();
+    benchQSpi();
+    benchSpiSlave();
+    benchI2CClocked();
+    benchI2CQueue();
+#endif
+#if XCPP_TEST_HARDWARE
+    //the keeper keeps its thread, so this one comes last
+    benchTime64Keeper();
+#endif
+    debug_printf("benchmarks done\n");
+}
+
+extern "C" void tile0_task1() { if (XCPP_TEST_BENCH) runBenches(); testScheduler(); };
 extern "C" void tile0_task2() { testcmdline();};
 extern "C" void tile1_task1() { };
 extern "C" void tile1_task2() {  };